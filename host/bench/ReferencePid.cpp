@@ -0,0 +1,57 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include "ReferencePid.h"
+
+ReferencePid::ReferencePid(const PidParameters& p) : pars(p), u(0.0f),
+up(0.0f), ud(0.0f), ui(0.0f), uio(0.0f), edo(0.0f), udo(0.0f)
+{
+
+}
+
+float ReferencePid::computeAction(const float w, const float y)
+{
+    float e = w - y;
+
+    up = pars.k*e;
+    ui = pars.k*(pars.Tsample/pars.Ti)*e + uio;
+
+    if((pars.Td != 0) && (pars.N != 0))
+    {
+        ud = pars.Td/(pars.Td+pars.N*pars.Tsample)*udo
+           + ((pars.k*pars.N*pars.Td)/(pars.Td+pars.N*pars.Tsample))*(e-edo);
+    }
+    else
+    {
+        ud = 0;
+    }
+
+    u = up + ui + ud;
+    u = std::max(pars.uMin, std::min(u, pars.uMax));
+    uio = u - up - ud;
+    udo = ud;
+    edo = e;
+
+    return u;
+}
+
+void ReferencePid::setParameters(const PidParameters& p)
+{
+    pars = p;
+}
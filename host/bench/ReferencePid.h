@@ -0,0 +1,42 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/PidRegulator.h"
+
+/**
+ * Reference PID regulator, computing the coefficients of the discrete-time
+ * transfer function at each step. Kept as baseline for the regulator
+ * benchmarks: its outputs must match the ones of PidRegulator.
+ */
+class ReferencePid
+{
+public:
+
+    ReferencePid(const PidParameters& p);
+
+    float computeAction(const float w, const float y);
+
+    void setParameters(const PidParameters& p);
+
+private:
+
+    PidParameters pars;
+    float u, up, ud, ui, uio, edo, udo;
+};
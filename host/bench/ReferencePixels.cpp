@@ -0,0 +1,52 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReferencePixels.h"
+
+void referenceFill(uint16_t *ptr, const int len, const uint16_t color)
+{
+    for(int i = 0; i < len; i++) *ptr++ = color;
+}
+
+void referenceColumn(uint16_t *ptr, const int len, const int stride,
+                     const uint16_t color)
+{
+    for(int i = 0; i < len; i++)
+    {
+        *ptr = color;
+        ptr += stride;
+    }
+}
+
+void referenceBlit(uint16_t *fb, const int fbWidth, const int fbHeight,
+                   const int x, const int y, const uint16_t *img,
+                   const int width, const int height)
+{
+    for(int i = 0; i < height; i++)
+    {
+        for(int j = 0; j < width; j++)
+        {
+            int px = x + j;
+            int py = y + i;
+            if((px < 0) || (px >= fbWidth) || (py < 0) || (py >= fbHeight))
+                continue;
+
+            fb[px + py * fbWidth] = img[j + i * width];
+        }
+    }
+}
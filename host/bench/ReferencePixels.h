@@ -0,0 +1,46 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Framebuffer loops of the display driver before the word fill and the row
+ * blit, writing one pixel at a time. Kept as baseline for the pixel
+ * benchmarks: their results must match the ones of the PixelOps kernels.
+ */
+
+/**
+ * Fill a run of contiguous pixels, one pixel per store.
+ */
+void referenceFill(uint16_t *ptr, const int len, const uint16_t color);
+
+/**
+ * Fill a column of pixels, one pixel per store.
+ */
+void referenceColumn(uint16_t *ptr, const int len, const int stride,
+                     const uint16_t color);
+
+/**
+ * Draw an image into a framebuffer pixel by pixel, checking each pixel
+ * against the framebuffer bounds.
+ */
+void referenceBlit(uint16_t *fb, const int fbWidth, const int fbHeight,
+                   const int x, const int y, const uint16_t *img,
+                   const int width, const int height);
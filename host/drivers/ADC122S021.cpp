@@ -0,0 +1,175 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <mutex>
+#include <miosix.h>
+#include "drivers/ADC122S021.h"
+#include "sim/Simulation.h"
+
+/*
+ * Host implementation of the ADC122S021 word exchange, the channel sequencing
+ * and the conversion to voltage are shared with the target driver. The SPI bus
+ * is replaced by a simulated ADC, which follows the same word protocol of the
+ * real one: the channel address carried by each word selects the channel
+ * converted while the next word is being exchanged. The conversion results are
+ * provided by the simulation through the ADC source function.
+ *
+ * In DMA mode the words are exchanged as soon as the transfer is started, a
+ * stalled ADC leaves the transfer pending and the calling thread waits for the
+ * same timeout of the polled mode.
+ */
+
+using namespace std;
+using namespace miosix;
+
+static mutex          sourceMutex;          // Protects the simulated ADC
+static sim::AdcSource source;               // Current ADC source
+static sim::AdcFault  fault = sim::AdcFault::NONE;  // Injected fault
+static size_t         wordCount = 0;        // Words exchanged so far
+static uint16_t       address = 0;          // Currently selected channel
+
+void sim::setAdcSource(const AdcSource& src)
+{
+    lock_guard< mutex > lock(sourceMutex);
+    source = src;
+}
+
+void sim::setAdcFault(const AdcFault f)
+{
+    lock_guard< mutex > lock(sourceMutex);
+    fault = f;
+}
+
+size_t sim::adcWordCount()
+{
+    lock_guard< mutex > lock(sourceMutex);
+    return wordCount;
+}
+
+/**
+ * \internal
+ * Exchange a word with the simulated ADC.
+ *
+ * @param tx: word sent to the ADC.
+ * @param rx: word received from the ADC.
+ * @return false if the ADC does not respond.
+ */
+static bool exchange(const uint16_t tx, uint16_t& rx)
+{
+    lock_guard< mutex > lock(sourceMutex);
+
+    if(fault == sim::AdcFault::STALL) return false;
+
+    AdcChannel channel = static_cast< AdcChannel >(address);
+    uint16_t   value   = source ? source(channel) : 0;
+    if(value == 0xFFFF) return false;
+
+    rx         = value;
+    address    = (tx >> 11) & 0x01;
+    wordCount += 1;
+
+    return true;
+}
+
+/**
+ * \internal
+ * Simulated DMA transfer, the words are moved as soon as the streams are
+ * enabled. The transfer stops at the first word the ADC does not respond to,
+ * leaving it pending.
+ *
+ * @param tx: words to be sent.
+ * @param rx: buffer for the received words.
+ * @param count: number of words to be exchanged.
+ * @param error: set to true if the DMA controller reports a transfer error.
+ * @return true if all the words have been moved.
+ */
+static bool dmaRun(const uint16_t *tx, uint16_t *rx, const uint16_t count,
+                   bool& error)
+{
+    {
+        lock_guard< mutex > lock(sourceMutex);
+        error = (fault == sim::AdcFault::DMA_ERROR);
+    }
+
+    if(error) return false;
+
+    for(uint16_t i = 0; i < count; i++)
+    {
+        if(exchange(tx[i], rx[i]) == false) return false;
+    }
+
+    return true;
+}
+
+
+ADC122S021::ADC122S021() : mode(AdcTransfer::DMA)
+{
+    // Default values for conversion offset and slope
+    CH_OFFSET[0] = 0.0f;
+    CH_OFFSET[1] = 0.0f;
+    CH_GAIN[0]   = 5.0f/4096.0f;
+    CH_GAIN[1]   = 5.0f/4096.0f;
+}
+
+ADC122S021::~ADC122S021()
+{
+
+}
+
+bool ADC122S021::transferPolled(const uint16_t *tx, uint16_t *rx,
+                                const uint16_t count)
+{
+    for(uint16_t i = 0; i < count; i++)
+    {
+        long long t = getTick();
+
+        while(exchange(tx[i], rx[i]) == false)
+        {
+            if((getTick() - t) > TIMEOUT)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ADC122S021::transferDma(const uint16_t *tx, uint16_t *rx,
+                             const uint16_t count)
+{
+    long long deadline = getTick() + TIMEOUT;
+    bool      error    = false;
+    bool      done     = dmaRun(tx, rx, count, error);
+
+    // Without the completion interrupt the thread sleeps until the timeout
+    // expires, then the streams are disabled.
+    if((done == false) && (error == false))
+        miosix::Thread::sleepUntil(deadline);
+
+    return done;
+}
+
+bool ADC122S021::transfer(const uint16_t *tx, uint16_t *rx,
+                          const uint16_t count)
+{
+    if(mode == AdcTransfer::DMA)
+        return transferDma(tx, rx, count);
+
+    return transferPolled(tx, rx, count);
+}
@@ -0,0 +1,58 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include "drivers/Blower.h"
+#include "sim/Simulation.h"
+
+/*
+ * Host implementation of the blower driver: the PWM compare value is kept in
+ * memory, with the same 10-bit resolution of the hardware timer.
+ */
+
+static std::atomic< uint16_t > compare(0);    // PWM compare value
+
+float sim::blowerOutput()
+{
+    return static_cast< float >(compare.load()) / 1023.0f;
+}
+
+
+Blower& Blower::instance()
+{
+    static Blower blower;
+    return blower;
+}
+
+Blower::Blower()
+{
+    compare = 0;
+}
+
+Blower::~Blower()
+{
+    compare = 0;
+}
+
+void Blower::setValue(const float u)
+{
+    // 10-bit DAC, maximum value is 1023
+    float dacValue = std::max(std::min(u, uMax()), uMin()) * 1023.0f;
+    compare = static_cast< uint16_t >(dacValue);
+}
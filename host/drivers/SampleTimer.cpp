@@ -0,0 +1,168 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "drivers/SampleTimer.h"
+#include "sim/Simulation.h"
+
+/*
+ * Host implementation of the sample timer, based either on the monotonic clock
+ * of the system or on the simulated time. Time keeps the 1us resolution and the
+ * 32-bit wrap around of the hardware counter.
+ *
+ * With the simulated time base, the threads waiting on the timer run in lock
+ * step with the simulation: each setTime() call resumes the threads whose
+ * wakeup time has been reached and waits for them to go back to sleep.
+ */
+
+using namespace std;
+using namespace std::chrono;
+
+static const steady_clock::time_point timerStart = steady_clock::now();
+static atomic< bool >      simulated(false);    // Simulated time base
+static atomic< uint32_t >  simTime(0);          // Simulated time, in us
+
+// Mutex and condition variable are never destroyed, as threads can still be
+// waiting on the timer at exit.
+static mutex&              simMutex = *new mutex;               // Wait state
+static condition_variable& simCond  = *new condition_variable;  // State change
+static thread::id          simDriver;           // Thread advancing the time
+static uint32_t            wakeup[SampleTimer::NUM_CHANNELS];   // Wakeup times
+static bool                pending[SampleTimer::NUM_CHANNELS];  // Channel used
+static unsigned int        running = 0;         // Resumed threads
+static thread_local bool   resumed = false;     // Resumed by setTime()
+
+/**
+ * \internal
+ * Check whether the wakeup time of a channel has been reached, must be called
+ * with the simulation mutex locked.
+ */
+static bool expired(const uint8_t channel)
+{
+    return static_cast< int32_t >(wakeup[channel] - simTime) <= 0;
+}
+
+void sim::setTime(const uint32_t time)
+{
+    unique_lock< mutex > lock(simMutex);
+
+    simTime   = time;
+    simulated = true;
+    simDriver = this_thread::get_id();
+    simCond.notify_all();
+
+    // Wait for the resumed threads to sleep again
+    simCond.wait(lock, []
+    {
+        for(uint8_t i = 0; i < SampleTimer::NUM_CHANNELS; i++)
+        {
+            if(pending[i] && expired(i)) return false;
+        }
+
+        return running == 0;
+    });
+}
+
+bool sim::timerWakeup(uint32_t& time)
+{
+    lock_guard< mutex > lock(simMutex);
+    bool found = false;
+
+    for(uint8_t i = 0; i < SampleTimer::NUM_CHANNELS; i++)
+    {
+        if(pending[i] == false) continue;
+
+        if((found == false) ||
+           (static_cast< int32_t >(wakeup[i] - time) < 0))
+            time = wakeup[i];
+
+        found = true;
+    }
+
+    return found;
+}
+
+
+SampleTimer& SampleTimer::instance()
+{
+    static SampleTimer timer;
+    return timer;
+}
+
+SampleTimer::SampleTimer()
+{
+
+}
+
+SampleTimer::~SampleTimer()
+{
+
+}
+
+uint32_t SampleTimer::now() const
+{
+    if(simulated) return simTime;
+
+    auto elapsed = steady_clock::now() - timerStart;
+    return static_cast< uint32_t >(duration_cast< microseconds >(elapsed)
+                                   .count());
+}
+
+bool SampleTimer::waitUntil(const uint32_t time, const uint8_t channel)
+{
+    if(channel >= NUM_CHANNELS)
+        return false;
+
+    if(simulated == false)
+    {
+        int32_t delta = static_cast< int32_t >(time - now());
+        if(delta <= 0)
+            return false;
+
+        this_thread::sleep_for(microseconds(delta));
+        return true;
+    }
+
+    unique_lock< mutex > lock(simMutex);
+
+    if((this_thread::get_id() == simDriver) ||
+       (static_cast< int32_t >(time - simTime) <= 0))
+        return false;
+
+    // A resumed thread is back to sleep
+    if(resumed)
+    {
+        resumed  = false;
+        running -= 1;
+    }
+
+    wakeup[channel]  = time;
+    pending[channel] = true;
+    simCond.notify_all();
+    simCond.wait(lock, [channel] { return expired(channel); });
+
+    pending[channel] = false;
+    resumed          = true;
+    running         += 1;
+
+    return true;
+}
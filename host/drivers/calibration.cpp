@@ -0,0 +1,59 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include "drivers/calibration.h"
+
+/*
+ * Host implementation of the analog calibration storage. The OTP area is
+ * simulated in RAM and starts blank, that is without valid calibration data.
+ */
+
+static adCal_t otpData;         // Simulated OTP content
+static bool    locked = false;  // OTP block locked
+
+adCal_t defaultAnalogCalibrationData()
+{
+    adCal_t defaultCal;
+
+    defaultCal.crc                 = 0;
+    defaultCal.SENS_SUPPLY_VOLTAGE = 5.0f;
+    defaultCal.ADC_OFFSET[0]       = 0.0f;
+    defaultCal.ADC_OFFSET[1]       = 0.0f;
+    defaultCal.ADC_SLOPE[0]        = 4096.0f / 5.0f;
+    defaultCal.ADC_SLOPE[1]        = 4096.0f / 5.0f;
+
+    return defaultCal;
+}
+
+bool readAnalogCalibrationData(adCal_t& cal)
+{
+    if(locked == false) return false;
+
+    cal = otpData;
+    return true;
+}
+
+void writeAnalogCalibrationData(adCal_t& cal)
+{
+    // OTP memory can be written only once
+    if(locked) return;
+
+    otpData = cal;
+    locked  = true;
+}
@@ -0,0 +1,104 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include "drivers/flash.h"
+#include "sim/Simulation.h"
+
+/*
+ * Host implementation of the flash driver. The whole 1MB flash memory is
+ * simulated with a RAM buffer having the same sector layout of the MCU one,
+ * starting in the erased state. As on the real device, programming can only
+ * clear bits: a sector must be erased before its content can be rewritten.
+ */
+
+static constexpr size_t FLASH_SIZE = 0x100000;     // 1MB
+
+static std::atomic< size_t > eraseCount(0);       // Sector erase operations
+static std::atomic< size_t > writeCount(0);       // Bytes programmed
+
+/**
+ * \internal
+ * Get the RAM buffer backing the simulated flash memory.
+ */
+static uint8_t *flashMemory()
+{
+    static std::vector< uint8_t > memory(FLASH_SIZE, 0xFF);
+    return memory.data();
+}
+
+/**
+ * \internal
+ * Get the offset of a sector from the beginning of the flash memory.
+ */
+static size_t sectorOffset(const uint8_t secNum)
+{
+    // Sectors 0 to 3 are 16kB, sector 4 is 64kB, the remaining ones are 128kB
+    if(secNum < 4)  return secNum * 0x4000;
+    if(secNum == 4) return 0x10000;
+
+    return 0x20000 + ((secNum - 5) * 0x20000);
+}
+
+size_t sim::flashEraseCount()
+{
+    return eraseCount;
+}
+
+size_t sim::flashWriteCount()
+{
+    return writeCount;
+}
+
+
+uintptr_t flash_sectorAddress(const uint8_t secNum)
+{
+    if(secNum > 11) return 0;
+
+    return reinterpret_cast< uintptr_t >(flashMemory() + sectorOffset(secNum));
+}
+
+bool flash_eraseSector(const uint8_t secNum)
+{
+    if(secNum > 11) return false;
+
+    size_t start = sectorOffset(secNum);
+    size_t end   = (secNum == 11) ? FLASH_SIZE : sectorOffset(secNum + 1);
+    memset(flashMemory() + start, 0xFF, end - start);
+    eraseCount += 1;
+
+    return true;
+}
+
+void flash_write(const uintptr_t address, const void *data, const size_t len)
+{
+    if((data == NULL) || (len == 0)) return;
+
+    // Writes outside the simulated memory, like the OTP area, are dropped
+    uintptr_t base = reinterpret_cast< uintptr_t >(flashMemory());
+    if((address < base) || ((address + len) > (base + FLASH_SIZE))) return;
+
+    const uint8_t *buf = reinterpret_cast< const uint8_t * >(data);
+    uint8_t *mem       = reinterpret_cast< uint8_t * >(address);
+    for(size_t i = 0; i < len; i++)
+        mem[i] &= buf[i];
+
+    writeCount += len;
+}
@@ -0,0 +1,1723 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <miosix.h>
+#include "Bed/ValveController.h"
+#include "Bed/SensorSampler.h"
+#include "Bed/AnalogSensors.h"
+#include "drivers/MPX5010.h"
+#include "drivers/FS1015CL.h"
+#include "common/FixedPoint.h"
+#include "common/PidBank.h"
+#include "common/Integrator.h"
+#include "BellJar/LevelController.h"
+#include "common/Persistence.h"
+#include "common/RingBuffer.h"
+#include "common/SpscRingBuffer.h"
+#include "drivers/PixelOps.h"
+#include "sim/Simulation.h"
+#include "sim/LungModel.h"
+#include "sim/BellJarModel.h"
+#include "bench/ReferencePid.h"
+#include "bench/ReferencePixels.h"
+#include "graphics/icons/warning_50x50.h"
+
+/*
+ * Host build entry point. The bed and bj modes run the firmware modules on top
+ * of the simulated hardware, in real time, for a given amount of time and
+ * print their outputs in CSV format. The lung and belljar modes close the
+ * loop on a plant model and step the firmware modules directly in simulated
+ * time, faster than real time, printing the performance metrics at the end.
+ * The remaining modes benchmark or check single modules.
+ *
+ * Usage:
+ * mev-host bed|bj [duration in s]
+ * mev-host lung [breaths]
+ * mev-host belljar [set point steps] [k Ti Td]
+ * mev-host pid [steps]
+ * mev-host fixed [steps]
+ * mev-host bank [steps]
+ * mev-host tune [transport delay in s]
+ * mev-host schedule [transport delay in s]
+ * mev-host adc
+ * mev-host integrator
+ * mev-host spsc [elements]
+ */
+
+using namespace std;
+using namespace miosix;
+using Clock = std::chrono::steady_clock;
+
+StateData state;
+BjState   bjState;
+
+/**
+ * Bell jar controller sample, taken at each controller step.
+ */
+struct BjSample
+{
+    long long time;
+    float     setPoint;
+    float     level;
+    float     output;
+    uint16_t  levelRaw;
+};
+
+static RingBuffer< BjSample, 256 > bjSamples;
+static loggerSample_t              samples[256];
+
+/**
+ * \internal
+ * Print the wakeup latency statistics of the sensor sampler.
+ */
+static void printJitter(const SensorSampler& sampler)
+{
+    uint32_t counts[SensorSampler::NUM_JITTER_BINS];
+    sampler.getJitterHistogram(counts);
+
+    for(size_t i = 0; i < SensorSampler::NUM_JITTER_BINS; i++)
+    {
+        unsigned long limit = SensorSampler::jitterBinLimit(i);
+        if(limit == UINT32_MAX)
+            printf("# >%lu us: %lu\n",
+                   static_cast< unsigned long >(SensorSampler::jitterBinLimit(i - 1)),
+                   static_cast< unsigned long >(counts[i]));
+        else
+            printf("# <=%lu us: %lu\n", limit,
+                   static_cast< unsigned long >(counts[i]));
+    }
+
+    printf("# max: %lu us, overruns: %lu\n",
+           static_cast< unsigned long >(sampler.maxJitter()),
+           static_cast< unsigned long >(sampler.overruns()));
+}
+
+/**
+ * \internal
+ * Run the bed firmware modules, the sensors read a constant value.
+ */
+static void runBed(const unsigned int duration)
+{
+    sim::setAdcSource([](const AdcChannel) { return 1024; });
+
+    state.volume_1 = 0.0f;
+    state.volume_2 = 0.0f;
+    state.enabled  = true;
+    state.tIns     = 1.0f;
+    state.IE       = 2.0f;
+    state.Fsample  = 0.0f;
+    state.cal.loadDefaultValues();
+
+    AnalogSensors& sensors = AnalogSensors::instance();
+    if(loadDataFromFlash(&(state.cal), sizeof(SensorCalibration)) == true)
+        sensors.applyCalibration(state.cal);
+
+    sensors.enableOversampling(1000, 40);
+
+    SensorSampler sampler;
+    ValveController vc(state);
+    sampler.start();
+    vc.start();
+
+    Thread::sleep(duration * 1000);
+
+    state.enabled = false;
+    vc.stop();
+    sampler.stop();
+    sensors.stop();
+
+    // Dump the log content
+    LogDecoder decoder;
+    decltype(state.log)::Span first, second;
+    size_t count;
+    while((count = state.log.readSpans(first, second, 256)) > 0)
+    {
+        const decltype(state.log)::Span *spans[2] = { &first, &second };
+        for(auto span : spans)
+        {
+            size_t n = decoder.decode(span->data, span->len, samples);
+            for(size_t i = 0; i < n; i++)
+            {
+                const loggerSample_t& s = samples[i];
+                printf("%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d\n",
+                       static_cast< unsigned long long >(s.timestamp),
+                       s.pressure, s.flow1, s.flow2, s.volume1, s.volume2,
+                       (s.valves & 0x01), (s.valves >> 1));
+            }
+        }
+
+        state.log.commitRead(count);
+    }
+
+    printJitter(sampler);
+}
+
+/**
+ * \internal
+ * Run the bell jar level controller in automatic mode, the level sensor reads
+ * a constant value.
+ */
+static void runBellJar(const unsigned int duration)
+{
+    sim::setAdcSource([](const AdcChannel) { return 2048; });
+
+    if(loadBjSettings() == false)
+    {
+        bjState.ctParams = PidParameters(1.0f, 10.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+                                         0.05f);
+        saveBjSettings();
+    }
+
+    bjState.ctMode     = CtrlMode::AUTO;
+    bjState.ctSetPoint = 0.6f;
+    bjState.manOutput  = 0.0f;
+    bjState.zeroLevel  = 0;
+    bjState.maxLevel   = 4095;
+
+    LevelController lc;
+    lc.setUpdateCallback([]()
+    {
+        BjSample s;
+        s.time     = getTick();
+        s.setPoint = bjState.ctSetPoint;
+        s.level    = bjState.levelNorm;
+        s.output   = sim::blowerOutput();
+        s.levelRaw = bjState.levelRaw;
+        bjSamples.push(s, true);
+    });
+
+    lc.start();
+
+    long long end = getTick() + (duration * 1000);
+    while(getTick() < end)
+    {
+        Thread::sleep(50);
+
+        BjSample s;
+        while(bjSamples.pop(s))
+        {
+            printf("%lld,%.3f,%.3f,%.3f,%d\n", s.time, s.setPoint, s.level,
+                                               s.output, s.levelRaw);
+        }
+    }
+
+    lc.stop();
+
+    printf("# flash erase: %zu, bytes written: %zu\n", sim::flashEraseCount(),
+                                                      sim::flashWriteCount());
+}
+
+/**
+ * \internal
+ * Convert a sensor output voltage to ADC counts, with the default ADC
+ * calibration.
+ */
+static uint16_t toCounts(const double voltage)
+{
+    double counts = std::round(voltage * 4096.0 / 5.0);
+    return static_cast< uint16_t >(std::max(0.0, std::min(counts, 4095.0)));
+}
+
+/**
+ * \internal
+ * Get the CPU time elapsed since a given point, in ns.
+ */
+static double elapsedNs(const Clock::time_point start)
+{
+    return chrono::duration< double, nano >(Clock::now() - start).count();
+}
+
+/**
+ * Minimum, maximum and mean of a set of values.
+ */
+struct Stats
+{
+    double   min = INFINITY;
+    double   max = -INFINITY;
+    double   sum = 0.0;
+    uint32_t num = 0;
+
+    void add(const double value)
+    {
+        min  = std::min(min, value);
+        max  = std::max(max, value);
+        sum += value;
+        num += 1;
+    }
+
+    double mean() const { return (num > 0) ? (sum / num) : NAN; }
+
+    void print(const char *name, const double scale = 1.0) const
+    {
+        if(num == 0)
+            printf("%-24s -\n", name);
+        else
+            printf("%-24s mean %10.3f  min %10.3f  max %10.3f\n", name,
+                   mean() * scale, min * scale, max * scale);
+    }
+};
+
+/**
+ * \internal
+ * Ventilate a simulated lung with the valve controller and measure it with
+ * the sensor sampler, in simulated time. The sensors are oversampled as in the
+ * bed firmware, the acquisition thread runs in lock step with the simulation.
+ * Each breath, the volumes integrated by the sampler are compared with the
+ * ones flown through the valves.
+ */
+static bool runLungSim(const unsigned int breaths)
+{
+    // 0.5 l/kPa compliance, inspiratory and expiratory time constants of 1s
+    // and 0.5s, 2kPa supply.
+    LungModel lung(5.0e-4, 2000.0, 1000.0, 2000.0);
+
+    // Sensor wiring and default output characteristics, see AnalogSensors
+    sim::setTime(0);
+    sim::setAdcSource([&lung](const AdcChannel channel)
+    {
+        bool ch1 = (channel == AdcChannel::_1);
+
+        if(adc::muxs::value() != 0)
+            return toCounts(ch1 ? ((lung.pressure() / 2222.222) + 0.2) : 0.2);
+
+        double flow = ch1 ? lung.inflow() : lung.outflow();
+        return toCounts((flow / 25.0) + 0.5);
+    });
+
+    state.volume_1 = 0.0f;
+    state.volume_2 = 0.0f;
+    state.enabled  = true;
+    state.tIns     = 1.0f;
+    state.IE       = 2.0f;
+    state.cal.loadDefaultValues();
+    AnalogSensors::instance().applyCalibration(state.cal);
+    AnalogSensors::instance().enableOversampling(1000, 40);
+
+    // Let the acquisition thread reach its first wait on the timer
+    uint32_t wakeup;
+    while(sim::timerWakeup(wakeup) == false) this_thread::yield();
+
+    SensorSampler   sampler;
+    ValveController vc(state);
+
+    Stats inspired, expired, peakTrue, peakMeas, samplerCpu, valveCpu;
+    unsigned long long time       = 0;    // Simulated time, in us
+    unsigned long long nextValve  = 0;
+    unsigned long long nextSample = 0;
+    unsigned int       count      = 0;
+    double             insStart   = 0.0;
+    double             expStart   = 0.0;
+    double             peak       = 0.0;
+    float              peakPress  = 0.0f;
+    bool               started    = false;
+    auto               wallStart  = Clock::now();
+
+    while(count < breaths)
+    {
+        // The wakeups of the acquisition thread are simulation events too
+        unsigned long long next = std::min(nextValve, nextSample);
+        if(sim::timerWakeup(wakeup))
+        {
+            uint32_t delta = wakeup - static_cast< uint32_t >(time);
+            next = std::min(next, time + delta);
+        }
+
+        lung.advance((next - time) / 1000000.0);
+        time = next;
+        sim::setTime(static_cast< uint32_t >(time));
+
+        if(time == nextValve)
+        {
+            bool wasOpen = (hpOutputs::out_1::value() != 0);
+
+            auto start = Clock::now();
+            nextValve += vc.step() * 1000;
+            valveCpu.add(elapsedNs(start));
+
+            lung.setValves(hpOutputs::out_1::value() != 0,
+                           hpOutputs::out_2::value() != 0);
+
+            // A new inspiration closes the previous breath. Volumes measured
+            // by the sampler are reset only at its next step.
+            if((wasOpen == false) && (hpOutputs::out_1::value() != 0))
+            {
+                if(started)
+                {
+                    double vIns = lung.inspiredVolume() - insStart;
+                    double vExp = lung.expiredVolume()  - expStart;
+                    inspired.add(state.volume_1 - vIns);
+                    expired.add(state.volume_2 - vExp);
+                    peakTrue.add(peak);
+                    peakMeas.add(peakPress);
+                    count += 1;
+                }
+
+                insStart  = lung.inspiredVolume();
+                expStart  = lung.expiredVolume();
+                peak      = 0.0;
+                peakPress = 0.0f;
+                started   = true;
+            }
+
+            peak = std::max(peak, lung.pressure());
+        }
+
+        if(time == nextSample)
+        {
+            auto start = Clock::now();
+            sampler.step(time);
+            samplerCpu.add(elapsedNs(start));
+
+            peakPress   = std::max(peakPress, state.press_1);
+            nextSample += 40000;
+        }
+    }
+
+    double wall = chrono::duration< double >(Clock::now() - wallStart).count();
+    double simulated = time / 1000000.0;
+
+    printf("breaths                  %u\n", count);
+    printf("simulated time           %.1f s (%.0fx real time)\n", simulated,
+                                                            simulated / wall);
+    inspired.print("inspired vol. err [ml]", 1000.0);
+    expired.print("expired vol. err [ml]", 1000.0);
+    peakTrue.print("peak pressure [Pa]");
+    peakMeas.print("meas. peak press. [Pa]");
+    samplerCpu.print("sampler step [ns]");
+    valveCpu.print("valve step [ns]");
+
+    // Each breath moves about 600 ml: the volume errors must stay within a
+    // couple of ml, a bias of the flow timestamps shows up well above that.
+    unsigned int failures = 0;
+    auto check = [&failures](const char *name, const Stats& err)
+    {
+        bool ok = (err.num > 0) && (fabs(err.mean()) < 1.5e-3)
+                && (err.min > -2.0e-3) && (err.max < 2.0e-3);
+        printf("%-24s %s\n", name, ok ? "ok" : "FAIL");
+        if(ok == false) failures += 1;
+    };
+
+    check("inspired volume", inspired);
+    check("expired volume", expired);
+
+    return failures == 0;
+}
+
+/**
+ * Blower command transport delay, a fixed number of controller steps.
+ */
+class DelayLine
+{
+public:
+
+    DelayLine(const unsigned int lag) : line(lag, 0.0) { }
+
+    double push(const double u)
+    {
+        line.push_back(u);
+        double out = line.front();
+        line.pop_front();
+        return out;
+    }
+
+private:
+
+    deque< double > line;
+};
+
+/**
+ * Bell jar model and set point range used by the closed loop simulations.
+ */
+struct JarSetup
+{
+    unsigned int lag      = 0;      ///< Transport delay, in controller steps
+    double       exponent = 1.0;    ///< Steady state characteristic exponent
+    double       low      = 0.3;    ///< Lower set point
+    double       high     = 0.7;    ///< Upper set point
+};
+
+/**
+ * \internal
+ * Close the bell jar level loop on the level model, in simulated time. The set
+ * point steps back and forth between the two levels of the setup, each step
+ * is evaluated for overshoot and 2% settling time.
+ */
+static void runBellJarSim(const unsigned int steps, const PidParameters& pars,
+                          const JarSetup& setup = JarSetup())
+{
+    // Full scale level for a full scale blower command, 2s time constant
+    BellJarModel jar(1.0, 2.0, setup.exponent);
+    DelayLine    delay(setup.lag);
+
+    // The level sensor measures the air gap above the bell jar
+    sim::setTime(0);
+    sim::setAdcSource([&jar](const AdcChannel)
+    {
+        return static_cast< uint16_t >(std::round((1.0 - jar.level())
+                                                  * 4095.0));
+    });
+
+    bjState.ctParams   = pars;
+    bjState.ctMode     = CtrlMode::AUTO;
+    bjState.ctSetPoint = 0.0f;
+    bjState.manOutput  = 0.0f;
+    bjState.zeroLevel  = 0;
+    bjState.maxLevel   = 4095;
+
+    LevelController lc;
+
+    Stats settling, overshoot, iae, stepCpu;
+    const double       ts      = pars.Tsample;
+    const unsigned int perStep = static_cast< unsigned int >
+                                 (std::lround(20.0 / ts));
+    unsigned long long time    = 0;    // Simulated time, in us
+    unsigned int       settled = 0;
+    auto               wallStart = Clock::now();
+
+    for(unsigned int i = 0; i < steps; i++)
+    {
+        double from = (i % 2 == 0) ? setup.low  : setup.high;
+        double to   = (i % 2 == 0) ? setup.high : setup.low;
+        double band = 0.02 * std::fabs(to - from);
+        double over = 0.0;
+        double err  = 0.0;
+        double last = 0.0;      // Last time outside the settling band
+
+        bjState.ctSetPoint = to;
+
+        for(unsigned int k = 1; k <= perStep; k++)
+        {
+            auto start = Clock::now();
+            lc.step();
+            stepCpu.add(elapsedNs(start));
+
+            jar.advance(ts, delay.push(sim::blowerOutput()));
+            time += static_cast< unsigned long long >(ts * 1000000.0);
+            sim::setTime(static_cast< uint32_t >(time));
+
+            double y = jar.level();
+            over  = std::max(over, (to > from) ? (y - to) : (to - y));
+            err  += std::fabs(to - y) * ts;
+            if(std::fabs(y - to) > band) last = k * ts;
+        }
+
+        // Settling is meaningful only for steps ending inside the band
+        if(last < (perStep * ts))
+        {
+            settling.add(last);
+            settled += 1;
+        }
+
+        // The first step starts from zero level, leave it out
+        if(i == 0) continue;
+
+        overshoot.add(100.0 * over / std::fabs(to - from));
+        iae.add(err);
+    }
+
+    double wall = chrono::duration< double >(Clock::now() - wallStart).count();
+    double simulated = time / 1000000.0;
+
+    printf("set point steps          %u (%u settled)\n", steps, settled);
+    printf("simulated time           %.1f s (%.0fx real time)\n", simulated,
+                                                            simulated / wall);
+    settling.print("settling time [s]");
+    overshoot.print("overshoot [%]");
+    iae.print("IAE [s]");
+    stepCpu.print("controller step [ns]");
+}
+
+/**
+ * \internal
+ * Run the relay autotuning of the level controller on the bell jar model,
+ * after bringing the bell jar steady at a given level in manual mode. Results
+ * are left in bjState.
+ *
+ * @return duration of the experiment, in s.
+ */
+static double tuneAt(const double level, const JarSetup& setup)
+{
+    PidParameters pars(1.0f, 10.0f, 0.0f, 10.0f, 0.0f, 1.0f, 0.05f);
+    BellJarModel  jar(1.0, 2.0, setup.exponent);
+    DelayLine     line(setup.lag);
+
+    sim::setTime(0);
+    sim::setAdcSource([&jar](const AdcChannel)
+    {
+        return static_cast< uint16_t >(std::round((1.0 - jar.level())
+                                                  * 4095.0));
+    });
+
+    bjState.ctParams   = pars;
+    bjState.ctMode     = CtrlMode::MAN;
+    bjState.manOutput  = std::pow(level, 1.0 / setup.exponent);
+    bjState.zeroLevel  = 0;
+    bjState.maxLevel   = 4095;
+
+    LevelController    lc;
+    unsigned long long time  = 0;
+    unsigned int       count = 0;
+
+    auto advance = [&]()
+    {
+        lc.step();
+        jar.advance(pars.Tsample, line.push(sim::blowerOutput()));
+        time  += static_cast< unsigned long long >(pars.Tsample * 1000000.0);
+        count += 1;
+        sim::setTime(static_cast< uint32_t >(time));
+    };
+
+    while(time < 20000000) advance();
+
+    // Relay experiment, the controller goes back to manual once done
+    bjState.ctMode = CtrlMode::TUNE;
+    count          = 0;
+
+    do
+    {
+        advance();
+    }
+    while(bjState.ctMode == CtrlMode::TUNE);
+
+    return count * pars.Tsample;
+}
+
+/**
+ * \internal
+ * Print the outcome of the last autotuning experiment.
+ */
+static void printTuning(const double duration)
+{
+    const char *status[] = { "idle", "running", "done", "failed" };
+    printf("experiment               %s, %.1f s\n",
+           status[static_cast< uint8_t >(bjState.tuneStatus)], duration);
+
+    if(bjState.tuneStatus != RelayAutotuner::Status::DONE)
+        return;
+
+    PidParameters& p = bjState.tuneParams;
+    printf("ultimate gain, period    %.3f, %.3f s\n", bjState.tuneKu,
+                                                     bjState.tuneTu);
+    printf("proposed k, Ti, Td       %.3f, %.3f, %.3f\n", p.k, p.Ti, p.Td);
+}
+
+/**
+ * \internal
+ * Run the relay autotuning of the level controller on the bell jar model with
+ * a given transport delay, then evaluate the proposed tuning on set point
+ * steps.
+ */
+static void runTuneSim(const double delay)
+{
+    JarSetup setup;
+    setup.lag = static_cast< unsigned int >(std::lround(delay / 0.05));
+
+    printf("transport delay [s]      %.2f\n", setup.lag * 0.05);
+    printTuning(tuneAt(0.5, setup));
+
+    if(bjState.tuneStatus == RelayAutotuner::Status::DONE)
+        runBellJarSim(10, bjState.tuneParams, setup);
+}
+
+/**
+ * \internal
+ * Compare a single tuning with gain scheduling on a bell jar with a quadratic
+ * steady state characteristic, whose gain grows with the level. The loop is
+ * autotuned at low, middle and high level; the middle tuning is used alone and
+ * then the three tunings are used as a schedule on the set point. Both are
+ * evaluated on set point steps at low and high level.
+ */
+static void runScheduleSim(const double delay)
+{
+    // Tuning levels on the schedule breakpoints
+    static constexpr double levels[] = { 0.25, 0.5, 0.75 };
+
+    JarSetup      setup;
+    PidParameters fixed;
+    GainSchedule  schedule;
+
+    setup.lag      = static_cast< unsigned int >(std::lround(delay / 0.05));
+    setup.exponent = 2.0;
+    schedule.clear();
+    schedule.mode  = GainSchedule::SET_POINT;
+
+    for(double level : levels)
+    {
+        printf("\nautotuning at level      %.2f\n", level);
+        bjState.ctSchedule.mode = GainSchedule::OFF;
+        printTuning(tuneAt(level, setup));
+
+        if(bjState.tuneStatus != RelayAutotuner::Status::DONE)
+            return;
+
+        schedule.setPoint(level, bjState.tuneParams);
+        if(level == 0.5) fixed = bjState.tuneParams;
+    }
+
+    const double ranges[][2] = { {0.15, 0.35}, {0.65, 0.85} };
+    for(auto& range : ranges)
+    {
+        setup.low  = range[0];
+        setup.high = range[1];
+
+        printf("\nfixed tuning, steps %.2f - %.2f\n", range[0], range[1]);
+        bjState.ctSchedule.mode = GainSchedule::OFF;
+        runBellJarSim(10, fixed, setup);
+
+        printf("\ngain scheduling, steps %.2f - %.2f\n", range[0], range[1]);
+        bjState.ctSchedule = schedule;
+        runBellJarSim(10, fixed, setup);
+    }
+}
+
+/**
+ * \internal
+ * Run a regulator over a sequence of inputs, return the CPU time per step in
+ * ns. Outputs are saved in the given buffer.
+ */
+template< class Regulator, typename T >
+static double timeRegulator(Regulator& pid, const vector< T >& w,
+                            const vector< T >& y, vector< T >& u)
+{
+    auto start = Clock::now();
+
+    for(size_t i = 0; i < w.size(); i++)
+        u[i] = pid.computeAction(w[i], y[i]);
+
+    return elapsedNs(start) / w.size();
+}
+
+/**
+ * \internal
+ * Output change of a regulator controlling the bell jar model when its
+ * proportional gain is doubled, shortly after a set point step.
+ */
+template< class Regulator >
+static double retuneBump(const PidParameters& pars)
+{
+    BellJarModel jar(1.0, 2.0);
+    Regulator    pid(pars);
+    float        u = 0.0f;
+
+    for(unsigned int i = 0; i < 1010; i++)
+    {
+        u = pid.computeAction((i < 1000) ? 0.3f : 0.5f, jar.level());
+        jar.advance(pars.Tsample, u);
+    }
+
+    PidParameters retuned = pars;
+    retuned.k *= 2.0f;
+    pid.setParameters(retuned);
+
+    float next = pid.computeAction(0.5f, jar.level());
+    return std::fabs(next - u);
+}
+
+/**
+ * \internal
+ * Compare the regulator with the reference implementation computing its
+ * coefficients at each step: CPU time per step, output equivalence over a set
+ * point square wave on the bell jar model and output bump on retuning.
+ */
+static void runPidBench(const unsigned int steps)
+{
+    PidParameters pars(2.0f, 2.0f, 0.5f, 10.0f, 0.0f, 1.0f, 0.05f);
+
+    // Record the inputs of a closed loop run
+    vector< float > w(steps), y(steps), u(steps), uRef(steps);
+    BellJarModel    jar(1.0, 2.0);
+    PidRegulator    loop(pars);
+
+    for(unsigned int i = 0; i < steps; i++)
+    {
+        w[i] = ((i / 400) % 2 == 0) ? 0.3f : 0.7f;
+        y[i] = jar.level();
+        jar.advance(pars.Tsample, loop.computeAction(w[i], y[i]));
+    }
+
+    PidRegulator pid(pars);
+    ReferencePid ref(pars);
+    double tNew = timeRegulator(pid, w, y, u);
+    double tRef = timeRegulator(ref, w, y, uRef);
+
+    unsigned int mismatch = 0;
+    double       maxDiff  = 0.0;
+    for(unsigned int i = 0; i < steps; i++)
+    {
+        if(u[i] != uRef[i]) mismatch += 1;
+        maxDiff = std::max(maxDiff, std::fabs(static_cast< double >(u[i])
+                                            - uRef[i]));
+    }
+
+    printf("steps                    %u\n", steps);
+    printf("step time [ns]           %.2f (reference %.2f)\n", tNew, tRef);
+    printf("output mismatches        %u, max difference %g\n", mismatch,
+                                                               maxDiff);
+    printf("retune bump              %g (reference %g)\n",
+           retuneBump< PidRegulator >(pars), retuneBump< ReferencePid >(pars));
+}
+
+/**
+ * \internal
+ * Run a sensor conversion over all the ADC codes, repeatedly. Return the CPU
+ * time per conversion in ns, the outputs of the last pass are converted to
+ * float and saved in the given buffer.
+ */
+template< typename T, class Convert >
+static double timeConversion(Convert convert, const vector< T >& voltage,
+                             vector< float >& out, const unsigned int passes)
+{
+    T sum = T(0.0f);
+    auto start = Clock::now();
+
+    for(unsigned int p = 0; p < passes; p++)
+    {
+        for(size_t i = 0; i < voltage.size(); i++)
+            sum += convert(voltage[i]);
+    }
+
+    double t = elapsedNs(start) / (passes * voltage.size());
+
+    for(size_t i = 0; i < voltage.size(); i++)
+        out[i] = static_cast< float >(convert(voltage[i]));
+
+    // Keep the accumulated value alive
+    volatile float sink = static_cast< float >(sum);
+    (void) sink;
+
+    return t;
+}
+
+/**
+ * \internal
+ * Largest difference between two sets of values, leaving out the positions
+ * where the reference is not valid.
+ */
+static double maxError(const vector< float >& ref, const vector< float >& val)
+{
+    double err = 0.0;
+    for(size_t i = 0; i < ref.size(); i++)
+    {
+        if(std::isnan(ref[i])) continue;
+        err = std::max(err, std::fabs(static_cast< double >(val[i]) - ref[i]));
+    }
+
+    return err;
+}
+
+/**
+ * \internal
+ * Compare the fixed point instances of the sensor converters and of the PID
+ * regulator with the floating point ones: CPU time per conversion or step and
+ * largest output difference.
+ */
+static void runFixedBench(const unsigned int steps)
+{
+    typedef Fixed< 15 > Q15;    // Sensor path, up to 64k Pa
+    typedef Fixed< 24 > Q24;    // Regulator, gains up to 128
+
+    ADC122S021& adc = ADC122S021::instance();
+    MPX5010< AdcChannel::_1 >      pressF(adc);
+    MPX5010< AdcChannel::_1, Q15 > pressQ(adc);
+    FS1015CL< AdcChannel::_1 >      flowF(adc);
+    FS1015CL< AdcChannel::_1, Q15 > flowQ(adc);
+
+    // Sensor voltages for all the ADC codes
+    vector< float > vF(4096), ref(4096), val(4096);
+    vector< Q15 >   vQ(4096);
+    for(uint16_t i = 0; i < 4096; i++)
+    {
+        vF[i] = adc.toVoltage(AdcChannel::_1, i);
+        vQ[i] = adc.toVoltage< Q15 >(AdcChannel::_1, i);
+    }
+
+    unsigned int passes = std::max(1u, steps / 4096);
+    double tF, tQ;
+
+    tF = timeConversion< float >([&](float v) { return pressF.getDiffPressure(v); },
+                                 vF, ref, passes);
+    tQ = timeConversion< Q15 >([&](Q15 v) { return pressQ.getDiffPressure(v); },
+                               vQ, val, passes);
+    printf("pressure Q15 [ns]        %.2f (float %.2f), max error %g Pa\n",
+           tQ, tF, maxError(ref, val));
+
+    tF = timeConversion< float >([&](float v) { return flowF.getFlowRate(v); },
+                                 vF, ref, passes);
+    tQ = timeConversion< Q15 >([&](Q15 v) { return flowQ.getFlowRate(v); },
+                               vQ, val, passes);
+    printf("flow Q15 [ns]            %.2f (float %.2f), max error %g l/min\n",
+           tQ, tF, maxError(ref, val));
+
+    // Regulator, replaying the inputs of a closed loop run
+    PidParameters pars(2.0f, 2.0f, 0.5f, 10.0f, 0.0f, 1.0f, 0.05f);
+    vector< float > w(steps), y(steps), u(steps), uQ(steps);
+    vector< Q24 >   wQ(steps), yQ(steps), out(steps);
+    BellJarModel    jar(1.0, 2.0);
+    PidRegulator    loop(pars);
+
+    for(unsigned int i = 0; i < steps; i++)
+    {
+        w[i]  = ((i / 400) % 2 == 0) ? 0.3f : 0.7f;
+        y[i]  = jar.level();
+        wQ[i] = Q24(w[i]);
+        yQ[i] = Q24(y[i]);
+        jar.advance(pars.Tsample, loop.computeAction(w[i], y[i]));
+    }
+
+    PidRegulator               pidF(pars);
+    BasicPidRegulator< Q24 >   pidQ(pars);
+    tF = timeRegulator(pidF, w, y, u);
+    tQ = timeRegulator(pidQ, wQ, yQ, out);
+
+    for(unsigned int i = 0; i < steps; i++)
+        uQ[i] = static_cast< float >(out[i]);
+
+    printf("PID Q24 step [ns]        %.2f (float %.2f), max error %g\n",
+           tQ, tF, maxError(u, uQ));
+}
+
+/**
+ * \internal
+ * Compare a bank of PID regulators with the same number of scalar ones, on
+ * the inputs recorded from a set of bell jars controlled in closed loop. Some
+ * channels are switched to tracking mode and retuned during the run.
+ */
+static void runBankBench(const unsigned int steps)
+{
+    static constexpr size_t N = 8;
+
+    PidParameters pars(2.0f, 2.0f, 0.5f, 10.0f, 0.0f, 1.0f, 0.05f);
+    PidParameters tuned(3.0f, 1.5f, 0.2f, 10.0f, 0.0f, 1.0f, 0.05f);
+
+    // Channel events, applied in the same way to both implementations
+    auto applyEvents = [&](const unsigned int i, auto trackOn, auto trackOff,
+                           auto trackOut, auto retune)
+    {
+        if(i == steps / 4)       trackOn(1);
+        if(i == steps / 2)       trackOff(1);
+        if(i == steps / 3)       trackOn(2);
+        if((i % 100) == 0)       trackOut(2, (i / 100) % 2 == 0 ? 0.2f : 0.8f);
+        if(i == (steps / 2) + 7) retune(5, tuned);
+    };
+
+    // Record the inputs of a closed loop run
+    vector< float > w(steps * N), y(steps * N), u(steps * N), uRef(steps * N);
+    vector< BellJarModel > jars;
+    PidBank< N >    loop(pars);
+
+    for(size_t c = 0; c < N; c++)
+        jars.emplace_back(1.0, 1.0 + 0.25 * c);
+
+    for(unsigned int i = 0; i < steps; i++)
+    {
+        applyEvents(i,
+                    [&](size_t c) { loop.enableTracking(c); },
+                    [&](size_t c) { loop.disableTracking(c); },
+                    [&](size_t c, float v) { loop.setTrackingOutput(c, v); },
+                    [&](size_t c, const PidParameters& p)
+                    { loop.setParameters(c, p); });
+
+        for(size_t c = 0; c < N; c++)
+        {
+            w[i*N + c] = (((i + 50*c) / 400) % 2 == 0) ? 0.3f : 0.7f;
+            y[i*N + c] = jars[c].level();
+        }
+
+        loop.step(&w[i*N], &y[i*N], nullptr);
+
+        for(size_t c = 0; c < N; c++)
+            jars[c].advance(pars.Tsample, loop.output(c));
+    }
+
+    // Replay with the scalar regulators and with the bank, events included
+    vector< PidRegulator > pids(N, PidRegulator(pars));
+    PidBank< N >           bank(pars);
+
+    for(unsigned int i = 0; i < steps; i++)
+    {
+        applyEvents(i,
+                    [&](size_t c) { pids[c].enableTracking(); },
+                    [&](size_t c) { pids[c].disableTracking(); },
+                    [&](size_t c, float v) { pids[c].setTrackingOutput(v); },
+                    [&](size_t c, const PidParameters& p)
+                    { pids[c].setParameters(p); });
+
+        applyEvents(i,
+                    [&](size_t c) { bank.enableTracking(c); },
+                    [&](size_t c) { bank.disableTracking(c); },
+                    [&](size_t c, float v) { bank.setTrackingOutput(c, v); },
+                    [&](size_t c, const PidParameters& p)
+                    { bank.setParameters(c, p); });
+
+        for(size_t c = 0; c < N; c++)
+            uRef[i*N + c] = pids[c].computeAction(w[i*N + c], y[i*N + c]);
+
+        bank.step(&w[i*N], &y[i*N], &u[i*N]);
+    }
+
+    unsigned int mismatch = 0;
+    for(size_t i = 0; i < u.size(); i++)
+    {
+        if(u[i] != uRef[i]) mismatch += 1;
+    }
+
+    // Timing, on a window of inputs small enough to stay in cache
+    unsigned int window = std::min(steps, 1000u);
+    unsigned int passes = std::max(1u, steps / window);
+    float        out[N];
+    float        sum = 0.0f;
+    double       num = static_cast< double >(passes) * window * N;
+
+    auto start = Clock::now();
+    for(unsigned int p = 0; p < passes; p++)
+    {
+        for(unsigned int i = 0; i < window; i++)
+        {
+            for(size_t c = 0; c < N; c++)
+                out[c] = pids[c].computeAction(w[i*N + c], y[i*N + c]);
+
+            sum += out[0];
+        }
+    }
+
+    double tRef = elapsedNs(start) / num;
+
+    start = Clock::now();
+    for(unsigned int p = 0; p < passes; p++)
+    {
+        for(unsigned int i = 0; i < window; i++)
+        {
+            bank.step(&w[i*N], &y[i*N], out);
+            sum += out[0];
+        }
+    }
+
+    double tBank = elapsedNs(start) / num;
+
+    // Keep the outputs alive
+    volatile float sink = sum;
+    (void) sink;
+
+    printf("channels                 %zu\n", N);
+    printf("steps                    %u\n", steps);
+    printf("channel step time [ns]   %.2f (scalar %.2f)\n", tBank, tRef);
+    printf("output mismatches        %u\n", mismatch);
+}
+
+/**
+ * \internal
+ * Element of the ring buffer stress test, carrying its sequence number in all
+ * the fields so that torn reads can be detected.
+ */
+struct SeqElement
+{
+    uint64_t seq[4];
+};
+
+/**
+ * \internal
+ * Stress the lock-free ring buffer with a producer and a consumer thread
+ * running flat out on a small buffer, so that the producer keeps overwriting
+ * the elements the consumer is reading. Checks that the consumer receives the
+ * elements in order, never gets a torn element and that every element is
+ * either received or accounted as dropped.
+ *
+ * @param erase: producer overwrites the oldest elements when full.
+ * @param spans: consumer reads through readSpans() and commitRead() instead
+ * of pop().
+ * @param count: number of elements pushed.
+ * @return true if no error has been detected.
+ */
+static bool spscStress(const bool erase, const bool spans, const uint64_t count)
+{
+    static SpscRingBuffer< SeqElement, 16 > buf;
+    while(buf.empty() == false)
+    {
+        SeqElement e;
+        buf.pop(e);
+    }
+
+    size_t           dropped0 = buf.dropped();
+    uint64_t         rejected = 0;
+    atomic< bool >   done(false);
+
+    thread producer([&]()
+    {
+        this_thread::yield();
+
+        for(uint64_t i = 1; i <= count; i++)
+        {
+            SeqElement e = {{ i, i, i, i }};
+            if(buf.push(e, erase) == false) rejected += 1;
+        }
+
+        done = true;
+    });
+
+    uint64_t received  = 0;
+    uint64_t discarded = 0;
+    uint64_t last      = 0;
+    uint64_t disorder  = 0;
+    uint64_t torn      = 0;
+
+    auto accept = [&](const SeqElement& e)
+    {
+        if((e.seq[1] != e.seq[0]) || (e.seq[2] != e.seq[0]) ||
+           (e.seq[3] != e.seq[0])) torn += 1;
+        if(e.seq[0] <= last) disorder += 1;
+
+        last      = e.seq[0];
+        received += 1;
+    };
+
+    while(true)
+    {
+        bool finished = done;
+
+        if(spans)
+        {
+            SeqElement tmp[8];
+            decltype(buf)::Span first, second;
+            size_t n = buf.readSpans(first, second, 8);
+            copy(first.data, first.data + first.len, tmp);
+            copy(second.data, second.data + second.len, tmp + first.len);
+
+            if(buf.commitRead(n))
+                for_each(tmp, tmp + n, accept);
+            else
+                discarded += n;
+
+            if(finished && (n == 0)) break;
+        }
+        else
+        {
+            SeqElement e;
+            if(buf.pop(e))
+                accept(e);
+            else if(finished)
+                break;
+        }
+    }
+
+    producer.join();
+
+    // Consumer-discarded spans overlap with the elements dropped by the
+    // producer, so the balance is exact only for pop(). The last element is
+    // always received, unless rejected.
+    uint64_t dropped = buf.dropped() - dropped0;
+    uint64_t balance = received + dropped + rejected;
+    bool     ok      = (disorder == 0) && (torn == 0)
+                    && ((erase == false) || (last == count))
+                    && (spans ? (balance <= count) : (balance == count));
+
+    printf("%-6s %-5s %-9lu %-9lu %-9lu %-9lu %-9lu %-8lu %-5lu %s\n",
+           erase ? "erase" : "reject", spans ? "spans" : "pop",
+           static_cast< unsigned long >(count),
+           static_cast< unsigned long >(received),
+           static_cast< unsigned long >(dropped),
+           static_cast< unsigned long >(rejected),
+           static_cast< unsigned long >(discarded),
+           static_cast< unsigned long >(disorder),
+           static_cast< unsigned long >(torn), ok ? "ok" : "FAIL");
+
+    return ok;
+}
+
+/**
+ * \internal
+ * Measure the latency of the producer while the consumer drains a log buffer
+ * holding 128k records, either one record at a time or in blocks through
+ * readSpans() and commitRead().
+ *
+ * @param name: name of the buffer type.
+ * @param spans: consumer reads in blocks.
+ */
+template< typename Buffer >
+static void drainLatency(const char *name, const bool spans)
+{
+    static constexpr size_t FILL  = 131072;
+    static constexpr size_t BLOCK = 256;
+
+    unique_ptr< Buffer > buf(new Buffer());
+    logRecord_t          rec = { 0, { 1, 2, 3, 4, 5 } };
+
+    for(size_t i = 0; i < FILL; i++) buf->push(rec, true);
+
+    atomic< bool > start(false);
+    atomic< bool > done(false);
+    double         drainTime = 0.0;
+
+    thread consumer([&]()
+    {
+        while(start == false) ;
+
+        auto   t0    = Clock::now();
+        size_t count = 0;
+        while(count < FILL)
+        {
+            if(spans)
+            {
+                typename Buffer::Span first, second;
+                size_t n = buf->readSpans(first, second,
+                                          std::min(BLOCK, FILL - count));
+                buf->commitRead(n);
+                count += n;
+            }
+            else
+            {
+                logRecord_t r;
+                if(buf->pop(r)) count += 1;
+            }
+        }
+
+        drainTime = elapsedNs(t0) / 1e6;
+        done      = true;
+    });
+
+    vector< double > latency;
+    latency.reserve(1 << 20);
+    start = true;
+    while(done == false)
+    {
+        auto t0 = Clock::now();
+        buf->push(rec, true);
+        latency.push_back(elapsedNs(t0));
+    }
+
+    consumer.join();
+
+    sort(latency.begin(), latency.end());
+    double mean = 0.0;
+    for(double l : latency) mean += l;
+    mean /= latency.size();
+
+    printf("%-8s %-5s %-10.2f %-8zu %-9.1f %-9.1f %.1f\n", name,
+           spans ? "spans" : "pop", drainTime, latency.size(), mean,
+           latency[(latency.size() * 99) / 100], latency.back());
+}
+
+/**
+ * \internal
+ * Stress test of the lock-free ring buffer and comparison of the producer
+ * latency with the mutex based one, while draining the log.
+ */
+static bool runSpscTest(const uint64_t count)
+{
+    printf("%-6s %-5s %-9s %-9s %-9s %-9s %-9s %-8s %s\n", "push", "read",
+           "pushed", "received", "dropped", "rejected", "discarded",
+           "disorder", "torn");
+
+    bool ok = true;
+    ok &= spscStress(true,  false, count);
+    ok &= spscStress(true,  true,  count);
+    ok &= spscStress(false, false, count);
+    ok &= spscStress(false, true,  count);
+
+    printf("\n%-8s %-5s %-10s %-8s %-9s %-9s %s\n", "buffer", "read",
+           "drain [ms]", "pushes", "mean [ns]", "p99 [ns]", "max [ns]");
+
+    using LogBuffer = decltype(state.log);
+    drainLatency< LogBuffer >("spsc", false);
+    drainLatency< LogBuffer >("spsc", true);
+    drainLatency< RingBuffer< logRecord_t, LogBuffer::capacity() > >("mutex",
+                                                                      false);
+    drainLatency< RingBuffer< logRecord_t, LogBuffer::capacity() > >("mutex",
+                                                                      true);
+
+    return ok;
+}
+
+/**
+ * \internal
+ * Compare the trapezoidal flow integrator with the rectangle rule previously
+ * used for the volumes, on synthetic flow waveforms sampled with a jittered
+ * period, and check its handling of invalid samples, duplicated samples,
+ * timestamp wrap around and reset requests.
+ */
+static bool runIntegratorTest()
+{
+    struct Waveform
+    {
+        const char              *name;
+        double                  duration;   // s
+        function< double(double) > flow;    // l/min, time in s
+    };
+
+    const Waveform waveforms[] =
+    {
+        // Inspiration with a sinusoidal flow profile
+        { "half-sine", 1.0, [](double t) { return 30.0 * sin(M_PI * t); } },
+        // Volume controlled inspiration, 100ms ramps
+        { "trapezoid", 1.0, [](double t)
+          {
+              return 30.0 * std::min(1.0, std::min(t, 1.0 - t) / 0.1);
+          } },
+        // Passive expiration, 300ms time constant
+        { "expiration", 1.5, [](double t) { return 40.0 * exp(-t / 0.3); } },
+    };
+
+    const double periods[] = { 0.001, 0.010, 0.040 };  // s, jitter is 1/8
+    mt19937      rng(1234);
+
+    printf("%-11s %-11s %-10s %-14s %s\n", "waveform", "period [ms]",
+           "volume [l]", "trapezoid [%]", "rectangle [%]");
+
+    for(const Waveform& wf : waveforms)
+    {
+        for(double period : periods)
+        {
+            uniform_real_distribution< double > jitter(-period / 8.0,
+                                                       period / 8.0);
+
+            // Sample times, in us as in the sensor sampler
+            vector< uint32_t > times;
+            for(double t = 0.0; t <= wf.duration; t += period)
+            {
+                double tj = std::max(0.0, t + ((t > 0.0) ? jitter(rng) : 0.0));
+                times.push_back(static_cast< uint32_t >(std::round(tj * 1e6)));
+            }
+
+            // Reference volume, from the first to the last sample
+            double t0    = times.front() * 1e-6;
+            double t1    = times.back() * 1e-6;
+            size_t steps = static_cast< size_t >((t1 - t0) / 1e-6);
+            double h     = (t1 - t0) / steps;
+            double exact = 0.5 * (wf.flow(t0) + wf.flow(t1));
+            for(size_t i = 1; i < steps; i++)
+                exact += wf.flow(t0 + i * h);
+
+            exact *= h / 60.0;
+
+            Integrator integ(1.0f / 60000000.0f);
+            double     rect = 0.0;
+            for(size_t i = 0; i < times.size(); i++)
+            {
+                float f = wf.flow(times[i] * 1e-6);
+                integ.update(f, times[i]);
+                if(i > 0) rect += (f / 60000000.0f) * (times[i] - times[i-1]);
+            }
+
+            printf("%-11s %-11.0f %-10.4f %-14.4f %.4f\n", wf.name,
+                   period * 1e3, exact,
+                   100.0 * (integ.value() - exact) / exact,
+                   100.0 * (rect - exact) / exact);
+        }
+    }
+
+    unsigned int failures = 0;
+    auto check = [&failures](const char *name, bool ok)
+    {
+        printf("%-36s %s\n", name, ok ? "ok" : "FAIL");
+        if(ok == false) failures += 1;
+    };
+
+    // Constant flow of 1.0 sampled every 1000us, the integral grows by 1000
+    // at each sample.
+    Integrator integ;
+    for(uint32_t t = 0; t <= 5000; t += 1000) integ.update(1.0f, t);
+    check("constant flow", integ.value() == 5000.0f);
+
+    integ.update(1.0f, 5000);
+    check("duplicated sample ignored", integ.value() == 5000.0f);
+
+    // The areas on both sides of an invalid sample are not accounted
+    integ.update(NAN, 6000);
+    integ.update(1.0f, 7000);
+    integ.update(1.0f, 8000);
+    check("invalid sample breaks integration", integ.value() == 6000.0f);
+
+    // Samples too far apart
+    integ.update(1.0f, 8000 + 2000000);
+    check("gap longer than maximum", integ.value() == 6000.0f);
+
+    // Reset request, integration restarts from the last sample
+    integ.requestReset();
+    integ.update(1.0f, 8000 + 2001000);
+    check("reset request", integ.value() == 1000.0f);
+
+    // Timestamps wrapping around
+    Integrator wrap;
+    for(uint32_t i = 0; i <= 4; i++)
+        wrap.update(1.0f, UINT32_MAX - 1999 + i * 1000);
+    check("timestamp wrap around", wrap.value() == 4000.0f);
+
+    printf("failures: %u\n", failures);
+
+    return failures == 0;
+}
+
+/**
+ * \internal
+ * Check the transfer logic of the ADC driver against the simulated ADC, in
+ * both transfer modes: channel pipelining, timeout of a stalled transfer, DMA
+ * errors and their conversion to invalid values.
+ */
+static bool runAdcTest()
+{
+    // Transfer timeout of the driver, in ms
+    static constexpr long long TIMEOUT = 10;
+
+    ADC122S021& adc = ADC122S021::instance();
+    unsigned int failures = 0;
+
+    auto check = [&failures](const char *mode, const char *name, bool ok)
+    {
+        printf("%-7s %-26s %s\n", mode, name, ok ? "ok" : "FAIL");
+        if(ok == false) failures += 1;
+    };
+
+    sim::setAdcSource([](const AdcChannel channel)
+    {
+        return (channel == AdcChannel::_1) ? 1000 : 3000;
+    });
+
+    const AdcChannel channels[] = { AdcChannel::_1, AdcChannel::_2,
+                                    AdcChannel::_2, AdcChannel::_1 };
+    const uint16_t   expected[] = { 1000, 3000, 3000, 1000 };
+    uint16_t         values[4];
+
+    for(AdcTransfer mode : { AdcTransfer::POLLED, AdcTransfer::DMA })
+    {
+        const char *name = (mode == AdcTransfer::DMA) ? "dma" : "polled";
+        adc.setTransferMode(mode);
+        sim::setAdcFault(sim::AdcFault::NONE);
+
+        // Four channels are sampled with five words
+        size_t words = sim::adcWordCount();
+        bool   ok    = adc.scan(channels, values, 4);
+        check(name, "scan values", ok && equal(values, values + 4, expected));
+        check(name, "scan words", (sim::adcWordCount() - words) == 5);
+        check(name, "single channel", adc.getRawValue(AdcChannel::_2) == 3000);
+        check(name, "voltage",
+              adc.getVoltage(AdcChannel::_1) ==
+              adc.toVoltage(AdcChannel::_1, static_cast< uint16_t >(1000)));
+
+        // A stalled ADC makes the transfer fail after the timeout
+        sim::setAdcFault(sim::AdcFault::STALL);
+        long long start = getTick();
+        ok = adc.scan(channels, values, 4);
+        long long elapsed = getTick() - start;
+        check(name, "stall fails", ok == false);
+        check(name, "stall timeout",
+              (elapsed >= TIMEOUT) && (elapsed < 5 * TIMEOUT));
+        check(name, "stall values", all_of(values, values + 4,
+                                           [](uint16_t v)
+                                           { return v == 0xFFFF; }));
+        check(name, "stall voltage is NaN",
+              std::isnan(adc.getVoltage(AdcChannel::_1)));
+
+        // DMA errors fail the transfer right away, only in DMA mode
+        sim::setAdcFault(sim::AdcFault::DMA_ERROR);
+        start   = getTick();
+        ok      = adc.scan(channels, values, 4);
+        elapsed = getTick() - start;
+        if(mode == AdcTransfer::DMA)
+        {
+            check(name, "DMA error fails", ok == false);
+            check(name, "DMA error is immediate", elapsed < TIMEOUT);
+            check(name, "DMA error values", values[0] == 0xFFFF);
+        }
+        else
+        {
+            check(name, "DMA error ignored",
+                  ok && equal(values, values + 4, expected));
+        }
+
+        // Transfers work again once the fault is removed
+        sim::setAdcFault(sim::AdcFault::NONE);
+        ok = adc.scan(channels, values, 4);
+        check(name, "recovery", ok && equal(values, values + 4, expected));
+    }
+
+    printf("failures: %u\n", failures);
+
+    return failures == 0;
+}
+
+/**
+ * \internal
+ * Throughput of a framebuffer kernel, run over and over for at least 0.2 s.
+ *
+ * @param pixels: pixels written by each run of the kernel.
+ * @param kernel: kernel, taking the run number.
+ * @return pixels written per us.
+ */
+template< typename Kernel >
+static double pixelRate(const size_t pixels, Kernel kernel)
+{
+    unsigned int runs = 0;
+    double       ns   = 0.0;
+    auto         start = Clock::now();
+
+    do
+    {
+        for(unsigned int i = 0; i < 64; i++, runs++) kernel(runs);
+        ns = elapsedNs(start);
+    }
+    while(ns < 200000000.0);
+
+    return (static_cast< double >(pixels) * runs) / (ns / 1000.0);
+}
+
+/**
+ * \internal
+ * Check the framebuffer fill and blit kernels of the display driver against
+ * the pixel by pixel loops they replace, then compare their throughput on a
+ * 240x320 framebuffer.
+ */
+static bool runPixelBench()
+{
+    static constexpr int WIDTH  = 240;
+    static constexpr int HEIGHT = 320;
+
+    unsigned int failures = 0;
+    auto check = [&failures](const char *name, bool ok)
+    {
+        printf("%-36s %s\n", name, ok ? "ok" : "FAIL");
+        if(ok == false) failures += 1;
+    };
+
+    // Every alignment and length of a short run, pixels around the run must
+    // be left untouched
+    bool rowOk = true;
+    bool colOk = true;
+    for(int offset = 0; offset < 4; offset++)
+    {
+        for(int len = 0; len <= 40; len++)
+        {
+            vector< uint16_t > a(64, 0xaaaa), b(64, 0xaaaa);
+            fillPixels(a.data() + offset, len, 0x1234);
+            referenceFill(b.data() + offset, len, 0x1234);
+            rowOk &= (a == b);
+
+            vector< uint16_t > c(7 * 48, 0xaaaa), d(7 * 48, 0xaaaa);
+            fillColumn(c.data() + offset, len, 7, 0x1234);
+            referenceColumn(d.data() + offset, len, 7, 0x1234);
+            colOk &= (c == d);
+        }
+    }
+
+    check("row fill, all alignments", rowOk);
+    check("column fill, all alignments", colOk);
+
+    // The warning icon at an odd column, and a full width image copied at
+    // once
+    const uint16_t *icon = warning_50x50.getData();
+    const int       iconW = warning_50x50.getWidth();
+    const int       iconH = warning_50x50.getHeight();
+    {
+        vector< uint16_t > a(WIDTH * HEIGHT, 0xaaaa), b(WIDTH * HEIGHT, 0xaaaa);
+        copyPixels(a.data() + 95 + 137 * WIDTH, WIDTH, icon, iconW, iconW,
+                   iconH);
+        referenceBlit(b.data(), WIDTH, HEIGHT, 95, 137, icon, iconW, iconH);
+        check("icon blit", a == b);
+
+        vector< uint16_t > img(WIDTH * 10);
+        for(size_t i = 0; i < img.size(); i++) img[i] = i;
+        copyPixels(a.data() + 20 * WIDTH, WIDTH, img.data(), WIDTH, WIDTH, 10);
+        referenceBlit(b.data(), WIDTH, HEIGHT, 0, 20, img.data(), WIDTH, 10);
+        check("full width blit", a == b);
+    }
+
+    vector< uint16_t > fb(WIDTH * HEIGHT);
+    uint16_t          *ptr = fb.data();
+    auto color = [](unsigned int run)
+    {
+        return static_cast< uint16_t >(0x1234 + run);
+    };
+
+    printf("\n%-18s %-8s %-13s %-13s %s\n", "kernel", "pixels",
+           "old [px/us]", "new [px/us]", "speedup");
+
+    auto report = [](const char *name, size_t pixels, double oldRate,
+                     double newRate)
+    {
+        printf("%-18s %-8zu %-13.1f %-13.1f %.2f\n", name, pixels, oldRate,
+               newRate, newRate / oldRate);
+    };
+
+    // Whole screen, merged into a single run
+    report("screen fill", fb.size(),
+           pixelRate(fb.size(), [&](unsigned int r)
+           {
+               referenceFill(ptr, fb.size(), color(r));
+           }),
+           pixelRate(fb.size(), [&](unsigned int r)
+           {
+               fillPixels(ptr, fb.size(), color(r));
+           }));
+
+    // 100x100 rectangle at an odd column, one run per row
+    report("rect fill 100x100", 10000,
+           pixelRate(10000, [&](unsigned int r)
+           {
+               for(int y = 0; y < 100; y++)
+                   referenceFill(ptr + 11 + (y + 50) * WIDTH, 100, color(r));
+           }),
+           pixelRate(10000, [&](unsigned int r)
+           {
+               for(int y = 0; y < 100; y++)
+                   fillPixels(ptr + 11 + (y + 50) * WIDTH, 100, color(r));
+           }));
+
+    report("horizontal line", 200,
+           pixelRate(200, [&](unsigned int r)
+           {
+               referenceFill(ptr + 1 + 160 * WIDTH, 200, color(r));
+           }),
+           pixelRate(200, [&](unsigned int r)
+           {
+               fillPixels(ptr + 1 + 160 * WIDTH, 200, color(r));
+           }));
+
+    report("vertical line", 300,
+           pixelRate(300, [&](unsigned int r)
+           {
+               referenceColumn(ptr + 120, 300, WIDTH, color(r));
+           }),
+           pixelRate(300, [&](unsigned int r)
+           {
+               fillColumn(ptr + 120, 300, WIDTH, color(r));
+           }));
+
+    // Icons have a fixed content, the run number is not used
+    const size_t iconPixels = iconW * iconH;
+    report("warning_50x50", iconPixels,
+           pixelRate(iconPixels, [&](unsigned int)
+           {
+               referenceBlit(ptr, WIDTH, HEIGHT, 95, 137, icon, iconW, iconH);
+           }),
+           pixelRate(iconPixels, [&](unsigned int)
+           {
+               copyPixels(ptr + 95 + 137 * WIDTH, WIDTH, icon, iconW, iconW,
+                          iconH);
+           }));
+
+    printf("\nfailures: %u\n", failures);
+
+    return failures == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2)
+    {
+        static const char *usage[] =
+        {
+            "bed|bj [duration in s]",
+            "lung [breaths]",
+            "belljar [set point steps] [k Ti Td]",
+            "pid [steps]",
+            "fixed [steps]",
+            "bank [steps]",
+            "tune [transport delay in s]",
+            "schedule [transport delay in s]",
+            "adc",
+            "integrator",
+            "spsc [elements]",
+            "pixels",
+        };
+
+        for(size_t i = 0; i < sizeof(usage)/sizeof(usage[0]); i++)
+            printf("%s %s %s\n", (i == 0) ? "Usage:" : "      ", argv[0],
+                   usage[i]);
+
+        return 1;
+    }
+
+    if(strcmp(argv[1], "bed") == 0)
+    {
+        runBed((argc > 2) ? atoi(argv[2]) : 5);
+    }
+    else if(strcmp(argv[1], "bj") == 0)
+    {
+        runBellJar((argc > 2) ? atoi(argv[2]) : 5);
+    }
+    else if(strcmp(argv[1], "lung") == 0)
+    {
+        if(runLungSim((argc > 2) ? atoi(argv[2]) : 100) == false) return 1;
+    }
+    else if(strcmp(argv[1], "belljar") == 0)
+    {
+        PidParameters pars(2.0f, 2.0f, 0.0f, 10.0f, 0.0f, 1.0f, 0.05f);
+        if(argc > 5)
+        {
+            pars.k  = atof(argv[3]);
+            pars.Ti = atof(argv[4]);
+            pars.Td = atof(argv[5]);
+        }
+
+        runBellJarSim((argc > 2) ? atoi(argv[2]) : 1000, pars);
+    }
+    else if(strcmp(argv[1], "pid") == 0)
+    {
+        runPidBench((argc > 2) ? atoi(argv[2]) : 1000000);
+    }
+    else if(strcmp(argv[1], "fixed") == 0)
+    {
+        runFixedBench((argc > 2) ? atoi(argv[2]) : 1000000);
+    }
+    else if(strcmp(argv[1], "bank") == 0)
+    {
+        runBankBench((argc > 2) ? atoi(argv[2]) : 200000);
+    }
+    else if(strcmp(argv[1], "tune") == 0)
+    {
+        runTuneSim((argc > 2) ? atof(argv[2]) : 0.5);
+    }
+    else if(strcmp(argv[1], "schedule") == 0)
+    {
+        runScheduleSim((argc > 2) ? atof(argv[2]) : 0.5);
+    }
+    else if(strcmp(argv[1], "adc") == 0)
+    {
+        if(runAdcTest() == false) return 1;
+    }
+    else if(strcmp(argv[1], "integrator") == 0)
+    {
+        if(runIntegratorTest() == false) return 1;
+    }
+    else if(strcmp(argv[1], "spsc") == 0)
+    {
+        if(runSpscTest((argc > 2) ? atoll(argv[2]) : 10000000) == false)
+            return 1;
+    }
+    else if(strcmp(argv[1], "pixels") == 0)
+    {
+        if(runPixelBench() == false) return 1;
+    }
+    else
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/**
+ * Host replacement of the mxgui in-memory image, enough to build the icons
+ * generated by pngconverter and to read back their pixels.
+ */
+namespace mxgui
+{
+
+template< typename T >
+class basic_image
+{
+public:
+
+    basic_image(const short height, const short width, const T *data) :
+                height(height), width(width), data(data) { }
+
+    short getHeight() const { return height; }
+
+    short getWidth() const { return width; }
+
+    const T *getData() const { return data; }
+
+private:
+
+    short   height;
+    short   width;
+    const T *data;
+};
+
+typedef basic_image< unsigned short > Image;
+
+}   // namespace mxgui
@@ -0,0 +1,277 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/**
+ * Host replacement of the subset of the miosix API used by the firmware
+ * modules built for Linux. Threads, mutexes and time are mapped onto the C++
+ * standard library, GPIOs are plain memory cells which can be inspected by the
+ * simulation code through the same static interface used by the firmware.
+ */
+
+/*
+ * GPIO port base addresses, only used as template arguments to tell apart the
+ * simulated pins.
+ */
+static constexpr unsigned int GPIOA_BASE = 0x40020000;
+static constexpr unsigned int GPIOB_BASE = 0x40020400;
+static constexpr unsigned int GPIOC_BASE = 0x40020800;
+static constexpr unsigned int GPIOD_BASE = 0x40020C00;
+static constexpr unsigned int GPIOE_BASE = 0x40021000;
+static constexpr unsigned int GPIOF_BASE = 0x40021400;
+static constexpr unsigned int GPIOG_BASE = 0x40021800;
+
+namespace miosix
+{
+
+typedef int Priority;
+
+static constexpr Priority     PRIORITY_MAX              = 4;
+static constexpr Priority     MAIN_PRIORITY             = 1;
+static constexpr unsigned int STACK_DEFAULT_FOR_PTHREAD = 2048;
+
+/**
+ * \internal
+ * Time origin of the simulated system, taken at the first call.
+ */
+inline std::chrono::steady_clock::time_point bootTime()
+{
+    static const auto boot = std::chrono::steady_clock::now();
+    return boot;
+}
+
+/**
+ * @return time elapsed since boot, in milliseconds.
+ */
+inline long long getTick()
+{
+    auto elapsed = std::chrono::steady_clock::now() - bootTime();
+    return std::chrono::duration_cast< std::chrono::milliseconds >(elapsed)
+           .count();
+}
+
+/**
+ * Busy wait for a given amount of time, mapped onto a sleep.
+ *
+ * @param us: time to wait, in microseconds.
+ */
+inline void delayUs(unsigned int us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+inline void ledOn()  { }
+inline void ledOff() { }
+
+/**
+ * Thread class, backed by a std::thread.
+ */
+class Thread
+{
+public:
+
+    enum Options
+    {
+        DEFAULT  = 0,
+        JOINABLE = 1
+    };
+
+    /**
+     * Create and start a new thread. Stack size and priority are ignored.
+     *
+     * @param startfunc: thread entry point.
+     * @param stacksize: thread stack size, in bytes.
+     * @param priority: thread priority.
+     * @param argv: argument passed to the entry point.
+     * @param options: thread options.
+     * @return the newly created thread.
+     */
+    static Thread *create(void (*startfunc)(void *), unsigned int stacksize,
+                          Priority priority = MAIN_PRIORITY,
+                          void *argv = nullptr,
+                          unsigned short options = DEFAULT)
+    {
+        (void) stacksize;
+        (void) priority;
+
+        Thread *t = new Thread;
+        t->thread = std::thread(startfunc, argv);
+        if((options & JOINABLE) == 0) t->thread.detach();
+
+        return t;
+    }
+
+    /**
+     * Wait for the termination of a joinable thread. As in miosix, the thread
+     * object is deleted once joined.
+     */
+    void join()
+    {
+        if(thread.joinable()) thread.join();
+        delete this;
+    }
+
+    /**
+     * Put the calling thread to sleep.
+     *
+     * @param ms: sleep time, in milliseconds.
+     */
+    static void sleep(unsigned int ms)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+
+    /**
+     * Put the calling thread to sleep until a given point in time.
+     *
+     * @param absoluteTime: wakeup time, in milliseconds since boot.
+     */
+    static void sleepUntil(long long absoluteTime)
+    {
+        std::this_thread::sleep_until(bootTime()
+                                    + std::chrono::milliseconds(absoluteTime));
+    }
+
+    static void yield()
+    {
+        std::this_thread::yield();
+    }
+
+private:
+
+    Thread() { }
+
+    std::thread thread;
+};
+
+/**
+ * Mutex class, backed by a std::mutex.
+ */
+class Mutex
+{
+public:
+
+    void lock()     { mutex.lock();          }
+    void unlock()   { mutex.unlock();        }
+    bool tryLock()  { return mutex.try_lock(); }
+
+private:
+
+    friend class ConditionVariable;
+
+    std::mutex mutex;
+};
+
+/**
+ * RAII lock, locks the mutex for the lifetime of the object.
+ */
+template< typename T >
+class Lock
+{
+public:
+
+    explicit Lock(T& m) : m(m) { m.lock(); }
+    ~Lock()                    { m.unlock(); }
+
+    T& get() { return m; }
+
+    Lock(const Lock&) = delete;
+    Lock& operator=(const Lock&) = delete;
+
+private:
+
+    T& m;
+};
+
+/**
+ * Condition variable class, backed by a std::condition_variable_any.
+ */
+class ConditionVariable
+{
+public:
+
+    template< typename T >
+    void wait(Lock< T >& l)  { cond.wait(l.get()); }
+    void signal()            { cond.notify_one(); }
+    void broadcast()         { cond.notify_all(); }
+
+private:
+
+    std::condition_variable_any cond;
+};
+
+/**
+ * GPIO modes.
+ */
+struct Mode
+{
+    enum Mode_
+    {
+        INPUT,
+        INPUT_PULL_UP,
+        INPUT_PULL_DOWN,
+        INPUT_ANALOG,
+        OUTPUT,
+        ALTERNATE
+    };
+};
+
+/**
+ * Simulated GPIO pin, each port/pin pair has its own state.
+ */
+template< unsigned int P, unsigned int N >
+class Gpio
+{
+public:
+
+    static void mode(Mode::Mode_ m)              { pin().mode = m; }
+    static void alternateFunction(unsigned char) { }
+    static void high()                           { pin().level = 1; }
+    static void low()                            { pin().level = 0; }
+    static int  value()                          { return pin().level; }
+
+    /**
+     * @return current mode of the pin.
+     */
+    static Mode::Mode_ getMode() { return pin().mode; }
+
+    Gpio() = delete;
+
+private:
+
+    struct State
+    {
+        std::atomic< Mode::Mode_ > mode;
+        std::atomic< int >         level;
+    };
+
+    static State& pin()
+    {
+        static State state{ {Mode::INPUT}, {0} };
+        return state;
+    }
+};
+
+} // namespace miosix
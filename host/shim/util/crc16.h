@@ -0,0 +1,46 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace miosix
+{
+
+/**
+ * CRC-16 CCITT of a block of data, host replacement of the miosix utility.
+ *
+ * @param message: data to be checked.
+ * @param length: data length, in bytes.
+ * @return CRC of the data.
+ */
+inline unsigned short crc16(const void *message, unsigned int length)
+{
+    const unsigned char *m = reinterpret_cast< const unsigned char * >(message);
+    unsigned short crc     = 0;
+
+    for(unsigned int i = 0; i < length; i++)
+    {
+        unsigned short x = ((crc >> 8) ^ m[i]) & 0xFF;
+        x  ^= x >> 4;
+        crc = (crc << 8) ^ (x << 12) ^ (x << 5) ^ x;
+    }
+
+    return crc;
+}
+
+} // namespace miosix
@@ -0,0 +1,40 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "BellJarModel.h"
+
+BellJarModel::BellJarModel(const double gain, const double tau,
+                           const double exponent) : gain(gain), tau(tau),
+                                                    expo(exponent), h(0.0)
+{
+
+}
+
+BellJarModel::~BellJarModel()
+{
+
+}
+
+void BellJarModel::advance(const double dt, const double u)
+{
+    double hEq = gain * std::pow(std::max(u, 0.0), expo);
+    h = hEq + ((h - hEq) * std::exp(-dt / tau));
+    h = std::max(0.0, std::min(h, 1.0));
+}
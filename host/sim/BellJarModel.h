@@ -0,0 +1,66 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/**
+ * Bell jar level model: the normalised level follows the blower command with
+ * first-order dynamics, with the command held constant between two steps.
+ * The steady state level can be a nonlinear function of the command, a power
+ * law. The model is advanced using its exact solution.
+ */
+class BellJarModel
+{
+public:
+
+    /**
+     * Constructor, the bell jar starts at zero level.
+     *
+     * @param gain: steady state level for a full scale command.
+     * @param tau: time constant, in s.
+     * @param exponent: exponent of the steady state characteristic, the
+     * steady state level is gain * u^exponent.
+     */
+    BellJarModel(const double gain, const double tau,
+                 const double exponent = 1.0);
+
+    /**
+     * Destructor.
+     */
+    ~BellJarModel();
+
+    /**
+     * Advance the model by a given amount of time.
+     *
+     * @param dt: time step, in s.
+     * @param u: blower command, in range 0.0 - 1.0.
+     */
+    void advance(const double dt, const double u);
+
+    /**
+     * @return current normalised level, in range 0.0 - 1.0.
+     */
+    double level() const { return h; }
+
+private:
+
+    double gain;    ///< Static gain
+    double tau;     ///< Time constant, in s
+    double expo;    ///< Steady state characteristic exponent
+    double h;       ///< Normalised level
+};
@@ -0,0 +1,80 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include "LungModel.h"
+
+LungModel::LungModel(const double compliance, const double rIns,
+                     const double rExp, const double pSupply) : c(compliance),
+                     rIns(rIns), rExp(rExp), pSup(pSupply), ev1(false),
+                     ev2(false), v(0.0), vIns(0.0), vExp(0.0)
+{
+
+}
+
+LungModel::~LungModel()
+{
+
+}
+
+void LungModel::setValves(const bool ev1, const bool ev2)
+{
+    this->ev1 = ev1;
+    this->ev2 = ev2;
+}
+
+void LungModel::advance(const double dt)
+{
+    // dv/dt = a - b*v, with the valve states held constant over the step
+    double gIns = ev1 ? (1.0 / rIns) : 0.0;
+    double gExp = ev2 ? (1.0 / rExp) : 0.0;
+    double a    = gIns * pSup;
+    double b    = (gIns + gExp) / c;
+
+    // Integral of the volume over the step, needed to compute the volume
+    // flown through each valve.
+    double vInt;
+    if(b > 0.0)
+    {
+        double vEq   = a / b;
+        double decay = std::exp(-b * dt);
+        vInt = (vEq * dt) + ((v - vEq) * (1.0 - decay) / b);
+        v    = vEq + ((v - vEq) * decay);
+    }
+    else
+    {
+        vInt = v * dt;
+    }
+
+    vIns += gIns * ((pSup * dt) - (vInt / c));
+    vExp += gExp * (vInt / c);
+}
+
+double LungModel::inflow() const
+{
+    if(ev1 == false) return 0.0;
+
+    return (pSup - pressure()) / rIns * 60.0;
+}
+
+double LungModel::outflow() const
+{
+    if(ev2 == false) return 0.0;
+
+    return pressure() / rExp * 60.0;
+}
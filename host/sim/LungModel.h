@@ -0,0 +1,109 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/**
+ * Single compartment lung model, ventilated through the two valves of the bed
+ * board. The inspiratory valve connects the lung to a constant pressure
+ * supply, the expiratory one vents it to the atmosphere, each one through its
+ * own flow resistance. Lung pressure is proportional to the volume above the
+ * relaxed one through the compliance.
+ *
+ * Since the valves are on/off, between two valve switchings the model is a
+ * linear first-order system and it is advanced using its exact solution: the
+ * result does not depend on the step size.
+ */
+class LungModel
+{
+public:
+
+    /**
+     * Constructor, the lung starts at its relaxed volume with both valves
+     * closed.
+     *
+     * @param compliance: lung compliance, in l/Pa.
+     * @param rIns: flow resistance of the inspiratory branch, in Pa*s/l.
+     * @param rExp: flow resistance of the expiratory branch, in Pa*s/l.
+     * @param pSupply: supply pressure, in Pa.
+     */
+    LungModel(const double compliance, const double rIns, const double rExp,
+              const double pSupply);
+
+    /**
+     * Destructor.
+     */
+    ~LungModel();
+
+    /**
+     * Set the state of the valves, kept until the next call.
+     *
+     * @param ev1: true if the inspiratory valve is open.
+     * @param ev2: true if the expiratory valve is open.
+     */
+    void setValves(const bool ev1, const bool ev2);
+
+    /**
+     * Advance the model by a given amount of time.
+     *
+     * @param dt: time step, in s.
+     */
+    void advance(const double dt);
+
+    /**
+     * @return lung volume above the relaxed one, in l.
+     */
+    double volume() const { return v; }
+
+    /**
+     * @return lung pressure, in Pa.
+     */
+    double pressure() const { return v / c; }
+
+    /**
+     * @return flow through the inspiratory valve, in l/min.
+     */
+    double inflow() const;
+
+    /**
+     * @return flow through the expiratory valve, in l/min.
+     */
+    double outflow() const;
+
+    /**
+     * @return total volume flown through the inspiratory valve, in l.
+     */
+    double inspiredVolume() const { return vIns; }
+
+    /**
+     * @return total volume flown through the expiratory valve, in l.
+     */
+    double expiredVolume() const { return vExp; }
+
+private:
+
+    double c;       ///< Compliance, in l/Pa
+    double rIns;    ///< Inspiratory resistance, in Pa*s/l
+    double rExp;    ///< Expiratory resistance, in Pa*s/l
+    double pSup;    ///< Supply pressure, in Pa
+    bool   ev1;     ///< Inspiratory valve open
+    bool   ev2;     ///< Expiratory valve open
+    double v;       ///< Volume, in l
+    double vIns;    ///< Total inspired volume, in l
+    double vExp;    ///< Total expired volume, in l
+};
@@ -0,0 +1,107 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include "drivers/ADC122S021.h"
+
+/**
+ * Hooks connecting the simulated hardware backends of the host build to the
+ * simulation code, which plays the role of the physical world: it provides the
+ * ADC inputs and observes the actuator outputs.
+ */
+namespace sim
+{
+
+/**
+ * Function providing the ADC output for a given channel, in ADC counts. A
+ * value of 0xFFFF signals a conversion failure, failing the transfer. Called by the thread sampling
+ * the ADC.
+ */
+using AdcSource = std::function< uint16_t(const AdcChannel) >;
+
+/**
+ * Set the function providing the ADC samples. By default all the channels
+ * read zero.
+ *
+ * @param source: new ADC source.
+ */
+void setAdcSource(const AdcSource& source);
+
+/**
+ * Faults that can be injected into the simulated ADC and SPI bus.
+ */
+enum class AdcFault
+{
+    NONE,       ///< Normal operation.
+    STALL,      ///< The ADC stops responding, transfers time out.
+    DMA_ERROR   ///< The DMA controller reports a transfer error.
+};
+
+/**
+ * Inject a fault into the simulated ADC, or remove it.
+ *
+ * @param fault: fault to be injected, NONE to restore normal operation.
+ */
+void setAdcFault(const AdcFault fault);
+
+/**
+ * @return number of words exchanged with the simulated ADC so far.
+ */
+size_t adcWordCount();
+
+/**
+ * Switch the sample timer to a simulated time base and set its current value.
+ * From then on, time advances only through this function. The threads waiting
+ * on the timer whose wakeup time has been reached are resumed, and the
+ * function returns once all of them are waiting on the timer again. Waits done
+ * by the thread advancing the time return immediately, so that it can step the
+ * firmware modules directly instead of running their threads.
+ *
+ * @param time: new timer value, in us.
+ */
+void setTime(const uint32_t time);
+
+/**
+ * Get the earliest wakeup time of the threads waiting on the simulated timer.
+ *
+ * @param time: earliest wakeup time, in us.
+ * @return false if no thread is waiting on the timer.
+ */
+bool timerWakeup(uint32_t& time);
+
+/**
+ * @return last value applied to the blower, in range 0.0 - 1.0, with the same
+ * resolution of the PWM output.
+ */
+float blowerOutput();
+
+/**
+ * @return number of flash sector erase operations performed so far.
+ */
+size_t flashEraseCount();
+
+/**
+ * @return number of bytes programmed into the flash memory so far.
+ */
+size_t flashWriteCount();
+
+} // namespace sim
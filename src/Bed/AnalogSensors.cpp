@@ -16,9 +16,12 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <miosix.h>
 #include "AnalogSensors.h"
+#include "drivers/SampleTimer.h"
 #include "drivers/MPX5010.h"
 #include "drivers/FS1015CL.h"
 #include "drivers/hwmapping.h"
@@ -42,6 +45,17 @@ static constexpr AdChConfig_t AdChConfig[4] =
     {0, AdcChannel::_2},    // FLOW_2
 };
 
+/**
+ * \internal
+ * Get the ADC channel configuration of a given sensor.
+ */
+static inline const AdChConfig_t& configOf(const Sensor sensor)
+{
+    return AdChConfig[static_cast< uint8_t >(sensor)];
+}
+
+
+constexpr size_t AnalogSensors::NUM_SENSORS;
 
 static ADC122S021& Adc = ADC122S021::instance();    // ADC driver
 static FS1015CL < AdcChannel::_1 > flow1(Adc);      // First flow sensor.
@@ -56,7 +70,10 @@ AnalogSensors& AnalogSensors::instance()
     return sensors;
 }
 
-AnalogSensors::AnalogSensors()
+AnalogSensors::AnalogSensors() : ActiveObject(STACK_DEFAULT_FOR_PTHREAD,
+                                              PRIORITY_MAX - 1),
+                                 oversampling(false), period(0), decimation(0),
+                                 averageTime(0), muxSettling(MUX_SETTLING_US)
 {
     adc::muxs::mode(Mode::OUTPUT);
     adc::muxs::high();
@@ -73,6 +90,9 @@ AnalogSensors::AnalogSensors()
         Adc.setConversionParameters(AdcChannel::_2, cal.ADC_SLOPE[1],
                                     cal.ADC_OFFSET[1]);
     }
+
+    for(size_t i = 0; i < NUM_SENSORS; i++)
+        average[i] = std::numeric_limits< float >::quiet_NaN();
 }
 
 AnalogSensors::~AnalogSensors()
@@ -82,42 +102,64 @@ AnalogSensors::~AnalogSensors()
 
 uint16_t AnalogSensors::getRawValue(const Sensor sensor)
 {
-    if(sensor > Sensor::FLOW_2)
-        return 0xFFFF;
+    SensorReading reading;
+    scan(&sensor, &reading, 1);
 
-    auto ch = selectInput(sensor);
-    return Adc.getRawValue(ch);
+    return reading.raw;
 }
 
 float AnalogSensors::getVoltage(const Sensor sensor)
 {
-    if(sensor > Sensor::FLOW_2)
-        return 0xFFFF;
+    SensorReading reading;
+    scan(&sensor, &reading, 1);
 
-    auto ch = selectInput(sensor);
-    return Adc.getVoltage(ch);
+    return reading.voltage;
 }
 
 float AnalogSensors::getValue(const Sensor sensor)
 {
-    float value = std::numeric_limits< float >::signaling_NaN();
+    SensorReading reading;
+    scan(&sensor, &reading, 1);
 
-    if(sensor > Sensor::FLOW_2)
-        return value;
+    return reading.value;
+}
 
-    selectInput(sensor);
+bool AnalogSensors::scan(const Sensor *sensors, SensorReading *readings,
+                         const size_t count)
+{
+    bool ok = true;
 
-    // Acquire measurement
-    switch(sensor)
+    for(size_t start = 0; start < count; start += NUM_SENSORS)
     {
-        case Sensor::PRESS_1: value = press1.getDiffPressure(); break;
-        case Sensor::PRESS_2: value = press2.getDiffPressure(); break;
-        case Sensor::FLOW_1:  value = flow1.getFlowRate();      break;
-        case Sensor::FLOW_2:  value = flow2.getFlowRate();      break;
-        default:                                                break;
+        size_t n = std::min(count - start, NUM_SENSORS);
+        float    raw[NUM_SENSORS];
+        uint32_t time;
+
+        if(acquire(&sensors[start], raw, n, time) == false)
+            ok = false;
+
+        for(size_t i = 0; i < n; i++)
+        {
+            Sensor         sensor  = sensors[start + i];
+            SensorReading& reading = readings[start + i];
+            reading.timestamp      = time;
+
+            if((sensor > Sensor::FLOW_2) || std::isnan(raw[i]))
+            {
+                reading.raw     = 0xFFFF;
+                reading.voltage = std::numeric_limits< float >::signaling_NaN();
+                reading.value   = reading.voltage;
+                continue;
+            }
+
+            AdcChannel ch   = configOf(sensor).channel;
+            reading.raw     = static_cast< uint16_t >(std::round(raw[i]));
+            reading.voltage = Adc.toVoltage(ch, raw[i]);
+            reading.value   = convert(sensor, reading.voltage);
+        }
     }
 
-    return value;
+    return ok;
 }
 
 AdcChannel AnalogSensors::selectInput(const Sensor sensor)
@@ -133,6 +175,22 @@ AdcChannel AnalogSensors::selectInput(const Sensor sensor)
     return config.channel;
 }
 
+bool AnalogSensors::enableOversampling(const uint32_t rate,
+                                       const uint32_t decimation)
+{
+    if((rate == 0) || (rate > 1000000) || (decimation == 0) || oversampling)
+        return false;
+
+    this->period     = 1000000 / rate;
+    this->decimation = decimation;
+    oversampling     = true;
+
+    if(start() == false)
+        oversampling = false;
+
+    return oversampling;
+}
+
 void AnalogSensors::applyCalibration(const SensorCalibration& cal)
 {
     // Tune flow sensors
@@ -143,3 +201,190 @@ void AnalogSensors::applyCalibration(const SensorCalibration& cal)
     press1.setOutputParameters(cal.pressSens[0].offset, cal.pressSens[0].slope);
     press2.setOutputParameters(cal.pressSens[1].offset, cal.pressSens[1].slope);
 }
+
+float AnalogSensors::convert(const Sensor sensor, const float voltage)
+{
+    float value = std::numeric_limits< float >::signaling_NaN();
+
+    switch(sensor)
+    {
+        case Sensor::PRESS_1: value = press1.getDiffPressure(voltage); break;
+        case Sensor::PRESS_2: value = press2.getDiffPressure(voltage); break;
+        case Sensor::FLOW_1:  value = flow1.getFlowRate(voltage);      break;
+        case Sensor::FLOW_2:  value = flow2.getFlowRate(voltage);      break;
+        default:                                                       break;
+    }
+
+    return value;
+}
+
+void AnalogSensors::run()
+{
+    static constexpr Sensor sensors[NUM_SENSORS] =
+    {
+        Sensor::PRESS_1, Sensor::PRESS_2, Sensor::FLOW_1, Sensor::FLOW_2
+    };
+
+    SampleTimer& timer = SampleTimer::instance();
+    uint32_t     sum[NUM_SENSORS]   = {0};
+    uint32_t     valid[NUM_SENSORS] = {0};
+    uint32_t     count = 0;
+    uint32_t     time  = timer.now();
+    uint32_t     first = time;
+
+    while(shouldStop() == false)
+    {
+        uint16_t raw[NUM_SENSORS];
+        sample(sensors, raw, NUM_SENSORS);
+        uint32_t sampleTime = timer.now();
+        if(count == 0) first = sampleTime;
+
+        // Failed conversions are left out of the average
+        for(size_t i = 0; i < NUM_SENSORS; i++)
+        {
+            if(raw[i] == 0xFFFF) continue;
+
+            sum[i]   += raw[i];
+            valid[i] += 1;
+        }
+
+        count += 1;
+        if(count >= decimation)
+        {
+            Lock< Mutex > lock(mutex);
+
+            for(size_t i = 0; i < NUM_SENSORS; i++)
+            {
+                if(valid[i] > 0)
+                    average[i] = static_cast< float >(sum[i])
+                               / static_cast< float >(valid[i]);
+                else
+                    average[i] = std::numeric_limits< float >::quiet_NaN();
+
+                sum[i]   = 0;
+                valid[i] = 0;
+            }
+
+            // The average is stamped at the middle of its window
+            averageTime = first + (sampleTime - first) / 2;
+            count       = 0;
+        }
+
+        // If the acquisition overran its period, restart from now instead of
+        // trying to catch up.
+        time += period;
+        if(timer.waitUntil(time, TIMER_CHANNEL) == false)
+            time = timer.now();
+    }
+}
+
+bool AnalogSensors::acquire(const Sensor *sensors, float *raw,
+                            const size_t count, uint32_t& timestamp)
+{
+    // Direct acquisition, one ADC conversion for each sensor
+    if(oversampling == false)
+    {
+        uint16_t values[NUM_SENSORS];
+        bool     ok = sample(sensors, values, count);
+        timestamp   = SampleTimer::instance().now();
+
+        for(size_t i = 0; i < count; i++)
+        {
+            if(values[i] == 0xFFFF)
+                raw[i] = std::numeric_limits< float >::quiet_NaN();
+            else
+                raw[i] = static_cast< float >(values[i]);
+        }
+
+        return ok;
+    }
+
+    // Oversampling enabled, take the last averaged values
+    Lock< Mutex > lock(mutex);
+    bool ok   = true;
+    timestamp = averageTime;
+
+    for(size_t i = 0; i < count; i++)
+    {
+        if(sensors[i] > Sensor::FLOW_2)
+            raw[i] = std::numeric_limits< float >::quiet_NaN();
+        else
+            raw[i] = average[static_cast< uint8_t >(sensors[i])];
+
+        if(std::isnan(raw[i]))
+            ok = false;
+    }
+
+    return ok;
+}
+
+bool AnalogSensors::sample(const Sensor *sensors, uint16_t *raw,
+                           const size_t count)
+{
+    AdcChannel channels[ADC122S021::MAX_SCAN];
+    size_t     index[ADC122S021::MAX_SCAN];
+    bool       ok = true;
+
+    for(size_t i = 0; i < count; i++)
+    {
+        raw[i] = 0xFFFF;
+        if(sensors[i] > Sensor::FLOW_2)
+            ok = false;
+    }
+
+    // Sensors are sampled in two groups, one for each multiplexer setting.
+    // The group matching the current setting goes first, so that the
+    // multiplexer is switched at most once and, when sampling repeatedly the
+    // same set of sensors, each scan starts from where the previous one ended.
+    uint8_t current = adc::muxs::value();
+    for(uint8_t pass = 0; pass < 2; pass++)
+    {
+        uint8_t mux = (pass == 0) ? current : (1 - current);
+        size_t  num = 0;
+
+        for(size_t i = 0; (i < count) && (num < ADC122S021::MAX_SCAN); i++)
+        {
+            if(sensors[i] > Sensor::FLOW_2)
+                continue;
+
+            if(configOf(sensors[i]).muxSel != mux)
+                continue;
+
+            channels[num] = configOf(sensors[i]).channel;
+            index[num]    = i;
+            num          += 1;
+        }
+
+        if(num == 0)
+            continue;
+
+        if(mux != adc::muxs::value())
+        {
+            selectInput(sensors[index[0]]);
+            waitMuxSettling();
+        }
+
+        uint16_t values[ADC122S021::MAX_SCAN];
+        if(Adc.scan(channels, values, num) == false)
+            ok = false;
+
+        for(size_t i = 0; i < num; i++)
+            raw[index[i]] = values[i];
+    }
+
+    return ok;
+}
+
+void AnalogSensors::setMuxSettlingTime(const uint32_t time)
+{
+    muxSettling = time;
+}
+
+void AnalogSensors::waitMuxSettling()
+{
+    if(muxSettling == 0)
+        return;
+
+    SampleTimer& timer = SampleTimer::instance();
+    timer.waitUntil(timer.now() + muxSettling, SETTLE_CHANNEL);
+}
@@ -19,6 +19,8 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
+#include "common/ActiveObject.h"
 #include "drivers/ADC122S021.h"
 
 /**
@@ -32,6 +34,18 @@ enum class Sensor : uint8_t
     FLOW_2  = 3,
 };
 
+/**
+ * Sample of a sensor output, as raw value, voltage and physical quantity.
+ */
+typedef struct
+{
+    uint16_t raw;       ///< Raw value, 0xFFFF on failure.
+    float    voltage;   ///< Output voltage, NaN on failure.
+    float    value;     ///< Sensor output, NaN on failure.
+    uint32_t timestamp; ///< Acquisition time, from SampleTimer, in us.
+}
+SensorReading;
+
 /**
  * Container class to handle sensors' calibration parameters.
  */
@@ -72,8 +86,14 @@ struct SensorCalibration
 
 /**
  * Analog sensors' manager class.
+ *
+ * By default each read triggers an ADC conversion. When oversampling is
+ * enabled, an acquisition thread paced by the sample timer samples all the
+ * sensors at a higher rate and averages blocks of consecutive samples (boxcar
+ * decimation): reads then return the last averaged values without accessing
+ * the ADC.
  */
-class AnalogSensors
+class AnalogSensors : public ActiveObject
 {
 public:
 
@@ -87,7 +107,7 @@ public:
     /**
      * Destructor.
      */
-    ~AnalogSensors();
+    virtual ~AnalogSensors();
 
     /**
      * Read the output value of a given sensor as raw ADC counts.
@@ -116,6 +136,19 @@ public:
      */
     float getValue(const Sensor sensor);
 
+    /**
+     * Sample a set of sensors, getting raw value, voltage and output value of
+     * each one from a single ADC conversion. Sensors are sampled in at most
+     * two ADC bursts, one for each multiplexer setting.
+     *
+     * @param sensors: sensors to be sampled, in order.
+     * @param readings: buffer for the sensor readings.
+     * @param count: number of sensors to be sampled.
+     * @return true on success, false if at least one sample failed.
+     */
+    bool scan(const Sensor *sensors, SensorReading *readings,
+              const size_t count);
+
     /**
      * Select multiplexer input given the sensor to sample.
      *
@@ -131,6 +164,28 @@ public:
      */
     void applyCalibration(const SensorCalibration& cal);
 
+    /**
+     * Start the oversampling acquisition thread. Once started, oversampling
+     * cannot be disabled.
+     *
+     * @param rate: raw acquisition rate, in Hz.
+     * @param decimation: number of raw samples averaged for each output value,
+     * the output rate is rate/decimation.
+     * @return true on success, false if the parameters are not valid or the
+     * oversampling has already been enabled.
+     */
+    bool enableOversampling(const uint32_t rate, const uint32_t decimation);
+
+    /**
+     * Set the time to wait after switching the input multiplexer before
+     * sampling the sensors connected to it. Default value is MUX_SETTLING_US.
+     *
+     * @param time: settling time, in us.
+     */
+    void setMuxSettlingTime(const uint32_t time);
+
+    static constexpr uint32_t MUX_SETTLING_US = 20;  ///< Default settling time
+
     /**
      * Copy constructor, deleted as this class is singleton.
      */
@@ -145,13 +200,13 @@ public:
      * operator== always return true: this class is singleton and is always
      * equal to itself.
      */
-    bool operator==(const AnalogSensors& other) const { return true; };
+    bool operator==(const AnalogSensors&) const { return true; };
 
     /**
      * operator!= always return false: this class is singleton and is never
      * different from itself.
      */
-    bool operator!=(const AnalogSensors& other) const { return false; };
+    bool operator!=(const AnalogSensors&) const { return false; };
 
 private:
 
@@ -159,4 +214,61 @@ private:
      * Default constructor
      */
     AnalogSensors();
+
+    /**
+     * Oversampling acquisition thread.
+     */
+    virtual void run() override;
+
+    /**
+     * Get the raw values of a set of sensors, either by sampling them or by
+     * taking the last averaged values when oversampling is enabled.
+     *
+     * @param sensors: sensors to be read, at most NUM_SENSORS.
+     * @param raw: buffer for the raw values, in ADC counts, NaN on failure.
+     * @param count: number of sensors to be read.
+     * @param timestamp: acquisition time of the values, in us.
+     * @return true on success, false if at least one value is not valid.
+     */
+    bool acquire(const Sensor *sensors, float *raw, const size_t count,
+                 uint32_t& timestamp);
+
+    /**
+     * Sample a set of sensors through the ADC, all the sensors sharing the
+     * same multiplexer setting are sampled in a single burst.
+     *
+     * @param sensors: sensors to be sampled, at most ADC122S021::MAX_SCAN.
+     * @param raw: buffer for the raw values, 0xFFFF on failure.
+     * @param count: number of sensors to be sampled.
+     * @return true on success, false if at least one sample failed.
+     */
+    bool sample(const Sensor *sensors, uint16_t *raw, const size_t count);
+
+    /**
+     * Put the calling thread to sleep for the multiplexer settling time. The
+     * wait uses its own sample timer channel, so that it does not clash with
+     * the one pacing the acquisition thread.
+     */
+    void waitMuxSettling();
+
+    /**
+     * Convert a voltage sample to the output value of a given sensor.
+     *
+     * @param sensor: sensor the sample belongs to.
+     * @param voltage: sensor output voltage.
+     * @return sensor output or NaN on failure.
+     */
+    float convert(const Sensor sensor, const float voltage);
+
+    static constexpr size_t   NUM_SENSORS     = 4;   ///< Number of sensors
+    static constexpr uint8_t  TIMER_CHANNEL   = 0;   ///< Sample timer channel
+    static constexpr uint8_t  SETTLE_CHANNEL  = 2;   ///< Mux settling channel
+
+    miosix::Mutex mutex;                ///< Mutex for averaged values access
+    bool          oversampling;         ///< Oversampling enabled
+    uint32_t      period;               ///< Raw acquisition period, in us
+    uint32_t      decimation;           ///< Decimation factor
+    float         average[NUM_SENSORS]; ///< Averaged raw values
+    uint32_t      averageTime;          ///< Middle of the averaging window
+    uint32_t      muxSettling;          ///< Mux settling time, in us
 };
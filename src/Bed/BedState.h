@@ -18,20 +18,10 @@
 
 #pragma once
 
-#include "common/RingBuffer.h"
+#include "common/SpscRingBuffer.h"
+#include "common/Integrator.h"
 #include "AnalogSensors.h"
-
-typedef struct
-{
-    unsigned long long int timestamp;
-    float   pressure;
-    float   flow1;
-    float   flow2;
-    float   volume1;
-    float   volume2;
-    uint8_t valves;
-}
-loggerSample_t;
+#include "LogFormat.h"
 
 struct StateData
 {
@@ -56,11 +46,12 @@ struct StateData
     float press_2;          // Output value of pressure sensor 2 in Pa
     float flow_1;           // Output value of flow sensor 1 in SLPM
     float flow_2;           // Output value of flow sensor 2 in SLPM
-    float volume_1;
-    float volume_2;
-    bool  resetVolumes;
+    float volume_1;         // Volume through flow sensor 1 in l
+    float volume_2;         // Volume through flow sensor 2 in l
+
+    Integrator volumeInt[2];    // Flow integrators, output in SLPM * us
 
-    RingBuffer< loggerSample_t, 131072 > log;   // 4MB buffer, 128k entries
+    SpscRingBuffer< logRecord_t, 262144 > log;  // 3MB buffer, 256k entries
 };
 
 extern StateData state;
@@ -0,0 +1,219 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "LogFormat.h"
+
+using namespace std;
+
+/**
+ * \internal
+ * Convert a value to a signed fixed-point representation, saturating it to
+ * the allowed range.
+ */
+static inline uint16_t toSigned(const float value, const float scale)
+{
+    if(std::isnan(value)) return static_cast< uint16_t >(LOG_INVALID);
+
+    float scaled = std::round(value * scale);
+    scaled = std::max(scaled, static_cast< float >(INT16_MIN + 1));
+    scaled = std::min(scaled, static_cast< float >(INT16_MAX));
+
+    return static_cast< uint16_t >(static_cast< int16_t >(scaled));
+}
+
+/**
+ * \internal
+ * Convert back a signed fixed-point value.
+ */
+static inline float fromSigned(const uint16_t value, const float scale)
+{
+    int16_t raw = static_cast< int16_t >(value);
+    if(raw == LOG_INVALID) return numeric_limits< float >::quiet_NaN();
+
+    return static_cast< float >(raw) / scale;
+}
+
+/**
+ * \internal
+ * Extract the elapsed time field from a record header.
+ */
+static inline uint16_t getDelta(const logRecord_t& record)
+{
+    return record.header >> LOG_DELTA_SHIFT;
+}
+
+/**
+ * \internal
+ * Extract the absolute timestamp from a sync record.
+ */
+static inline unsigned long long getSyncTime(const logRecord_t& record)
+{
+    unsigned long long time = 0;
+    for(int i = 3; i >= 0; i--)
+        time = (time << 16) | record.payload[i];
+
+    return time;
+}
+
+
+
+LogEncoder::LogEncoder() : lastTime(0), sinceSync(0), synced(false)
+{
+
+}
+
+LogEncoder::~LogEncoder()
+{
+
+}
+
+size_t LogEncoder::encode(const loggerSample_t& sample, logRecord_t *records)
+{
+    uint16_t valves = sample.valves & LOG_VALVES_MASK;
+    uint16_t delta  = LOG_DELTA_UNKNOWN;
+    size_t   count  = 0;
+
+    if(synced && (sample.timestamp >= lastTime)
+              && ((sample.timestamp - lastTime) < LOG_DELTA_UNKNOWN))
+    {
+        delta = static_cast< uint16_t >(sample.timestamp - lastTime);
+    }
+
+    // Sync record, carries the absolute timestamp of the sample following it.
+    if((delta == LOG_DELTA_UNKNOWN) || (sinceSync >= SYNC_INTERVAL))
+    {
+        logRecord_t& sync = records[count++];
+        sync.header = (delta << LOG_DELTA_SHIFT) | LOG_SYNC_FLAG | valves;
+
+        unsigned long long time = sample.timestamp;
+        for(int i = 0; i < 4; i++)
+        {
+            sync.payload[i] = static_cast< uint16_t >(time & 0xFFFF);
+            time >>= 16;
+        }
+
+        sync.payload[4] = 0;
+        delta           = 0;
+        sinceSync       = 0;
+        synced          = true;
+    }
+
+    logRecord_t& rec = records[count++];
+    rec.header     = (delta << LOG_DELTA_SHIFT) | valves;
+    rec.payload[0] = toSigned(sample.pressure, LOG_PRESS_SCALE);
+    rec.payload[1] = toSigned(sample.flow1,    LOG_FLOW_SCALE);
+    rec.payload[2] = toSigned(sample.flow2,    LOG_FLOW_SCALE);
+    rec.payload[3] = toSigned(sample.volume1,  LOG_VOLUME_SCALE);
+    rec.payload[4] = toSigned(sample.volume2,  LOG_VOLUME_SCALE);
+
+    lastTime   = sample.timestamp;
+    sinceSync += count;
+
+    return count;
+}
+
+void LogEncoder::reset()
+{
+    synced = false;
+}
+
+
+
+LogDecoder::LogDecoder() : time(0), timeValid(false)
+{
+
+}
+
+LogDecoder::~LogDecoder()
+{
+
+}
+
+size_t LogDecoder::decode(const logRecord_t *records, const size_t count,
+                          loggerSample_t *samples)
+{
+    // Time base unknown: walk back from the first sync record to find the
+    // oldest record whose timestamp can be recovered.
+    size_t             anchor     = count;
+    unsigned long long anchorTime = 0;
+
+    if(timeValid == false)
+    {
+        size_t sync = 0;
+        while((sync < count) && ((records[sync].header & LOG_SYNC_FLAG) == 0))
+            sync++;
+
+        if(sync < count)
+        {
+            anchor     = sync;
+            anchorTime = getSyncTime(records[sync]);
+
+            while((anchor > 0) && (getDelta(records[anchor]) != LOG_DELTA_UNKNOWN))
+            {
+                anchorTime -= getDelta(records[anchor]);
+                anchor     -= 1;
+            }
+        }
+    }
+
+    size_t numSamples = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        const logRecord_t& rec   = records[i];
+        uint16_t           delta = getDelta(rec);
+
+        if(i == anchor)
+        {
+            time      = anchorTime;
+            timeValid = true;
+        }
+        else if(timeValid)
+        {
+            if(delta == LOG_DELTA_UNKNOWN)
+                timeValid = false;
+            else
+                time += delta;
+        }
+
+        if((rec.header & LOG_SYNC_FLAG) != 0)
+        {
+            time      = getSyncTime(rec);
+            timeValid = true;
+            continue;
+        }
+
+        loggerSample_t& sample = samples[numSamples++];
+        sample.timestamp = timeValid ? time : 0;
+        sample.pressure  = fromSigned(rec.payload[0], LOG_PRESS_SCALE);
+        sample.flow1     = fromSigned(rec.payload[1], LOG_FLOW_SCALE);
+        sample.flow2     = fromSigned(rec.payload[2], LOG_FLOW_SCALE);
+        sample.volume1   = fromSigned(rec.payload[3], LOG_VOLUME_SCALE);
+        sample.volume2   = fromSigned(rec.payload[4], LOG_VOLUME_SCALE);
+        sample.valves    = rec.header & LOG_VALVES_MASK;
+    }
+
+    return numSamples;
+}
+
+void LogDecoder::reset()
+{
+    timeValid = false;
+}
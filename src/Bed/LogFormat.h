@@ -0,0 +1,170 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Logger sample, in its decoded form.
+ */
+typedef struct
+{
+    unsigned long long int timestamp;
+    float   pressure;
+    float   flow1;
+    float   flow2;
+    float   volume1;
+    float   volume2;
+    uint8_t valves;
+}
+loggerSample_t;
+
+/**
+ * Packed log record, as stored in the on-device log buffer.
+ *
+ * Header layout:
+ * - bit 0-1:  valve status, bit 0 is EV1 and bit 1 is EV2.
+ * - bit 2:    sync record flag.
+ * - bit 3:    reserved, always zero.
+ * - bit 4-15: time elapsed since the previous record, in ms. The maximum
+ *             value, 0xFFF, means that the elapsed time is unknown.
+ *
+ * Payload layout for sample records, all the fields are signed:
+ * - payload[0]: pressure, in units of 1/PRESS_SCALE Pa.
+ * - payload[1]: flow rate 1, in units of 1/FLOW_SCALE SLPM.
+ * - payload[2]: flow rate 2, in units of 1/FLOW_SCALE SLPM.
+ * - payload[3]: volume 1, in units of 1/VOLUME_SCALE l.
+ * - payload[4]: volume 2, in units of 1/VOLUME_SCALE l.
+ * Values out of range are saturated, invalid (NaN) values are encoded with
+ * the LOG_INVALID marker.
+ *
+ * Payload layout for sync records:
+ * - payload[0-3]: absolute timestamp in ms, least significant word first.
+ * - payload[4]:   reserved, always zero.
+ */
+typedef struct
+{
+    uint16_t header;
+    uint16_t payload[5];
+}
+logRecord_t;
+
+static constexpr uint16_t LOG_VALVES_MASK    = 0x0003;
+static constexpr uint16_t LOG_SYNC_FLAG      = 0x0004;
+static constexpr uint16_t LOG_DELTA_SHIFT    = 4;
+static constexpr uint16_t LOG_DELTA_UNKNOWN  = 0x0FFF;
+
+static constexpr float    LOG_PRESS_SCALE    = 2.0f;      ///< counts/Pa
+static constexpr float    LOG_FLOW_SCALE     = 250.0f;    ///< counts/SLPM
+static constexpr float    LOG_VOLUME_SCALE   = 5000.0f;   ///< counts/l
+
+static constexpr int16_t  LOG_INVALID        = INT16_MIN;
+
+/**
+ * Encoder for the packed log format.
+ *
+ * Timestamps are stored as the time elapsed since the previous record. A sync
+ * record carrying the absolute timestamp is inserted before the first sample,
+ * periodically every SYNC_INTERVAL records and whenever the elapsed time does
+ * not fit into the record header, so that the time base can be recovered even
+ * when the oldest records have been overwritten.
+ */
+class LogEncoder
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    LogEncoder();
+
+    /**
+     * Destructor.
+     */
+    ~LogEncoder();
+
+    /**
+     * Encode a sample, producing either one sample record or a sync record
+     * followed by the sample record.
+     *
+     * @param sample: sample to be encoded.
+     * @param records: destination for the encoded records, must have room for
+     * at least two elements.
+     * @return number of records written.
+     */
+    size_t encode(const loggerSample_t& sample, logRecord_t *records);
+
+    /**
+     * Force the emission of a sync record before the next sample.
+     */
+    void reset();
+
+    static constexpr uint16_t SYNC_INTERVAL = 128;  ///< Records between syncs
+
+private:
+
+    unsigned long long lastTime;    ///< Timestamp of the last record.
+    uint16_t           sinceSync;   ///< Records since the last sync record.
+    bool               synced;      ///< Time base is valid.
+};
+
+/**
+ * Decoder for the packed log format.
+ */
+class LogDecoder
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    LogDecoder();
+
+    /**
+     * Destructor.
+     */
+    ~LogDecoder();
+
+    /**
+     * Decode a block of consecutive records, the time base is kept between
+     * successive calls. When the time base is not yet known, the timestamps
+     * of the samples preceding the first sync record of the block are
+     * reconstructed backwards from it. Samples whose timestamp cannot be
+     * recovered are given a timestamp of zero.
+     *
+     * @param records: pointer to the records to be decoded.
+     * @param count: number of records.
+     * @param samples: destination for the decoded samples, must have room for
+     * at least count elements.
+     * @return number of samples decoded.
+     */
+    size_t decode(const logRecord_t *records, const size_t count,
+                  loggerSample_t *samples);
+
+    /**
+     * Discard the current time base.
+     */
+    void reset();
+
+private:
+
+    unsigned long long time;        ///< Timestamp of the last record.
+    bool               timeValid;   ///< Time base is valid.
+};
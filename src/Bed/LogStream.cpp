@@ -0,0 +1,143 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include "LogStream.h"
+
+uint16_t logCrc16(const void *data, const size_t len)
+{
+    const uint8_t *ptr = reinterpret_cast< const uint8_t * >(data);
+    uint16_t crc = 0xFFFF;
+
+    for(size_t i = 0; i < len; i++)
+    {
+        uint16_t x = ((crc >> 8) ^ ptr[i]) & 0xFF;
+        x  ^= x >> 4;
+        crc = (crc << 8) ^ (x << 12) ^ (x << 5) ^ x;
+    }
+
+    return crc;
+}
+
+
+
+LogFrameWriter::LogFrameWriter() : sequence(0)
+{
+
+}
+
+LogFrameWriter::~LogFrameWriter()
+{
+
+}
+
+size_t LogFrameWriter::build(const logRecord_t *records, const size_t count,
+                             const bool last, const bool gap,
+                             uint8_t *frame)
+{
+    size_t numRecords = (count > LOG_FRAME_MAX_RECORDS) ? LOG_FRAME_MAX_RECORDS
+                                                        : count;
+    size_t payload    = numRecords * sizeof(logRecord_t);
+
+    frame[0] = LOG_FRAME_SYNC_1;
+    frame[1] = LOG_FRAME_SYNC_2;
+    frame[2] = sequence & 0xFF;
+    frame[3] = sequence >> 8;
+    frame[4] = static_cast< uint8_t >(numRecords);
+    frame[5] = (last ? LOG_FRAME_LAST : 0) | (gap ? LOG_FRAME_GAP : 0);
+    memcpy(&frame[LOG_FRAME_HEADER_SIZE], records, payload);
+
+    size_t   end = LOG_FRAME_HEADER_SIZE + payload;
+    uint16_t crc = logCrc16(&frame[2], end - 2);
+    frame[end]     = crc & 0xFF;
+    frame[end + 1] = crc >> 8;
+
+    sequence += 1;
+
+    return end + sizeof(uint16_t);
+}
+
+void LogFrameWriter::reset()
+{
+    sequence = 0;
+}
+
+
+
+LogFrameParser::LogFrameParser() : pos(0), size(0), numErrors(0)
+{
+    memset(buffer, 0x00, sizeof(buffer));
+}
+
+LogFrameParser::~LogFrameParser()
+{
+
+}
+
+bool LogFrameParser::push(const uint8_t byte)
+{
+    // Hunt for the sync word
+    if(pos == 0)
+    {
+        if(byte == LOG_FRAME_SYNC_1) buffer[pos++] = byte;
+        return false;
+    }
+
+    if(pos == 1)
+    {
+        if(byte == LOG_FRAME_SYNC_2)
+            buffer[pos++] = byte;
+        else
+            pos = (byte == LOG_FRAME_SYNC_1) ? 1 : 0;
+
+        return false;
+    }
+
+    buffer[pos++] = byte;
+
+    // Header complete, validate the record count
+    if(pos == LOG_FRAME_HEADER_SIZE)
+    {
+        if(buffer[4] > LOG_FRAME_MAX_RECORDS)
+        {
+            pos = 0;
+            return false;
+        }
+
+        size = LOG_FRAME_HEADER_SIZE + buffer[4] * sizeof(logRecord_t)
+             + sizeof(uint16_t);
+    }
+
+    if((pos < LOG_FRAME_HEADER_SIZE) || (pos < size))
+        return false;
+
+    pos = 0;
+
+    size_t   end = size - sizeof(uint16_t);
+    uint16_t crc = buffer[end] | (buffer[end + 1] << 8);
+    if(crc != logCrc16(&buffer[2], end - 2))
+    {
+        numErrors += 1;
+        return false;
+    }
+
+    memcpy(frameRecords, &buffer[LOG_FRAME_HEADER_SIZE],
+           buffer[4] * sizeof(logRecord_t));
+
+    return true;
+}
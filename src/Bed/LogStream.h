@@ -0,0 +1,163 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "LogFormat.h"
+
+/*
+ * Framed binary stream used to dump the log records over the console.
+ *
+ * Frame layout, multi-byte fields are little endian:
+ * - offset 0: sync word, bytes 0xA5 0x5A.
+ * - offset 2: 16-bit frame sequence number, starting from zero.
+ * - offset 4: number of records in the frame, up to LOG_FRAME_MAX_RECORDS.
+ * - offset 5: flags, bit 0 marks the last frame of the dump, bit 1 marks a
+ *             frame preceded by records lost on the device side.
+ * - offset 6: records, in the same format of the on-device log buffer.
+ * - end:      CRC16-CCITT of all the fields following the sync word.
+ */
+
+static constexpr uint8_t LOG_FRAME_SYNC_1       = 0xA5;
+static constexpr uint8_t LOG_FRAME_SYNC_2       = 0x5A;
+static constexpr uint8_t LOG_FRAME_LAST         = 0x01;
+static constexpr uint8_t LOG_FRAME_GAP          = 0x02;
+static constexpr size_t  LOG_FRAME_HEADER_SIZE  = 6;
+static constexpr size_t  LOG_FRAME_MAX_RECORDS  = 32;
+static constexpr size_t  LOG_FRAME_MAX_SIZE     = LOG_FRAME_HEADER_SIZE
+                                                + LOG_FRAME_MAX_RECORDS
+                                                * sizeof(logRecord_t)
+                                                + sizeof(uint16_t);
+
+/**
+ * Compute the CRC16-CCITT (polynomial 0x1021, initial value 0xFFFF) of a
+ * block of data.
+ *
+ * @param data: pointer to data.
+ * @param len: data length in bytes.
+ * @return CRC of the data block.
+ */
+uint16_t logCrc16(const void *data, const size_t len);
+
+/**
+ * Builder for the frames of the log stream.
+ */
+class LogFrameWriter
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    LogFrameWriter();
+
+    /**
+     * Destructor.
+     */
+    ~LogFrameWriter();
+
+    /**
+     * Build a new frame.
+     *
+     * @param records: records to be put into the frame.
+     * @param count: number of records, at most LOG_FRAME_MAX_RECORDS.
+     * @param last: true if this is the last frame of the dump.
+     * @param gap: true if some records have been lost between the previous
+     * frame and this one.
+     * @param frame: destination buffer, must be at least LOG_FRAME_MAX_SIZE
+     * bytes long.
+     * @return size of the frame in bytes.
+     */
+    size_t build(const logRecord_t *records, const size_t count,
+                 const bool last, const bool gap, uint8_t *frame);
+
+    /**
+     * Restart the frame sequence numbering from zero.
+     */
+    void reset();
+
+private:
+
+    uint16_t sequence;  ///< Sequence number of the next frame.
+};
+
+/**
+ * Byte-oriented parser for the frames of the log stream.
+ */
+class LogFrameParser
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    LogFrameParser();
+
+    /**
+     * Destructor.
+     */
+    ~LogFrameParser();
+
+    /**
+     * Feed a new byte to the parser.
+     *
+     * @param byte: incoming byte.
+     * @return true when the byte completes a frame with a valid CRC.
+     */
+    bool push(const uint8_t byte);
+
+    /**
+     * @return pointer to the records of the last valid frame.
+     */
+    const logRecord_t *records() const { return frameRecords; }
+
+    /**
+     * @return number of records in the last valid frame.
+     */
+    size_t count() const { return buffer[4]; }
+
+    /**
+     * @return sequence number of the last valid frame.
+     */
+    uint16_t sequence() const { return buffer[2] | (buffer[3] << 8); }
+
+    /**
+     * @return true if the last valid frame is the last one of the dump.
+     */
+    bool isLast() const { return (buffer[5] & LOG_FRAME_LAST) != 0; }
+
+    /**
+     * @return true if records have been lost before the last valid frame.
+     */
+    bool isAfterGap() const { return (buffer[5] & LOG_FRAME_GAP) != 0; }
+
+    /**
+     * @return number of frames discarded due to a CRC mismatch.
+     */
+    uint32_t crcErrors() const { return numErrors; }
+
+private:
+
+    uint8_t     buffer[LOG_FRAME_MAX_SIZE];             ///< Frame buffer.
+    logRecord_t frameRecords[LOG_FRAME_MAX_RECORDS];    ///< Aligned records.
+    size_t      pos;                                    ///< Bytes received.
+    size_t      size;                                   ///< Frame size.
+    uint32_t    numErrors;                              ///< CRC errors.
+};
@@ -18,16 +18,33 @@
 
 #include <miosix.h>
 #include <cmath>
+#include <cstdint>
 #include "SensorSampler.h"
 #include "BedState.h"
+#include "drivers/SampleTimer.h"
 
 using namespace std;
 using namespace miosix;
 
+static constexpr Sensor allSensors[4] =
+{
+    Sensor::PRESS_1, Sensor::PRESS_2, Sensor::FLOW_1, Sensor::FLOW_2
+};
 
-SensorSampler::SensorSampler() : sensors(AnalogSensors::instance())
+// Upper limits of the latency histogram bins, in us
+static constexpr uint32_t jitterLimits[SensorSampler::NUM_JITTER_BINS] =
 {
+    10, 20, 50, 100, 200, 500, 1000, UINT32_MAX
+};
+
 
+SensorSampler::SensorSampler() : ActiveObject(STACK_DEFAULT_FOR_PTHREAD,
+                                              PRIORITY_MAX - 2),
+                                 sensors(AnalogSensors::instance()),
+                                 maxLatency(0), numOverruns(0), tail(0)
+{
+    for(size_t i = 0; i < NUM_JITTER_BINS; i++)
+        histogram[i] = 0;
 }
 
 SensorSampler::~SensorSampler()
@@ -35,105 +52,123 @@ SensorSampler::~SensorSampler()
 
 }
 
-void SensorSampler::run()
+void SensorSampler::getJitterHistogram(uint32_t *counts) const
+{
+    for(size_t i = 0; i < NUM_JITTER_BINS; i++)
+        counts[i] = histogram[i];
+}
+
+uint32_t SensorSampler::jitterBinLimit(const size_t bin)
 {
-    unsigned long long time = getTick();
-    uint8_t            turn = 0;
-    uint8_t            tail = 0;
+    if(bin >= NUM_JITTER_BINS)
+        return UINT32_MAX;
+
+    return jitterLimits[bin];
+}
 
-    sensors.selectInput(Sensor::PRESS_1);
+void SensorSampler::run()
+{
+    // Update steps are triggered by the sample timer, trigger time is kept
+    // on 64 bits to have a time base not wrapping around.
+    SampleTimer&       timer   = SampleTimer::instance();
+    unsigned long long trigger = timer.now();
 
     while(!should_stop)
     {
-        if((turn % 2) == 0)
-        {
-            // Update pressure measurements
-            state.press1_raw = sensors.getRawValue(Sensor::PRESS_1);
-            state.press1_out = sensors.getVoltage(Sensor::PRESS_1);
-            state.press_1    = sensors.getValue(Sensor::PRESS_1);
-
-            state.press2_raw = 0;    // sensors.getRawValue(Sensor::PRESS_2);
-            state.press2_out = 0.0f; // sensors.getVoltage(Sensor::PRESS_2);
-            state.press_2    = 0.0f; // sensors.getValue(Sensor::PRESS_2);
-
-            // Preset input multiplexer for next turn;
-            sensors.selectInput(Sensor::FLOW_1);
-        }
+        step(trigger);
+
+        trigger += updateStep * 1000;
+
+        // Wait for the next trigger. When the step is already late, the
+        // next one starts immediately to recover the time base.
+        bool onTime = timer.waitUntil(static_cast< uint32_t >(trigger),
+                                      TIMER_CHANNEL);
+        if(onTime == false) numOverruns += 1;
+
+        updateJitter(timer.now() - static_cast< uint32_t >(trigger));
+    }
+}
+
+void SensorSampler::step(const unsigned long long trigger)
+{
+    // Update all the measurements, the sensors are sampled in two ADC
+    // bursts, one for each input multiplexer setting.
+    SensorReading r[4];
+    sensors.scan(allSensors, r, 4);
+
+    state.press1_raw = r[0].raw;
+    state.press1_out = r[0].voltage;
+    state.press_1    = r[0].value;
+
+    state.press2_raw = r[1].raw;
+    state.press2_out = r[1].voltage;
+    state.press_2    = r[1].value;
+
+    state.flow1_raw  = r[2].raw;
+    state.flow1_out  = r[2].voltage;
+    state.flow_1     = r[2].value;
+
+    state.flow2_raw  = r[3].raw;
+    state.flow2_out  = r[3].voltage;
+    state.flow_2     = r[3].value;
+
+    // Flow rate is in l/min while sample timestamps are in us, hence we
+    // have to divide the integral by 60 s/min * 1000000 us/s.
+    //
+    // Update volumes only if valve controller is running: when stopped,
+    // integration is suspended and volumes keep their last value.
+    float flow1 = state.enabled ? state.flow_1 : NAN;
+    float flow2 = state.enabled ? state.flow_2 : NAN;
+
+    state.volume_1 = state.volumeInt[0].update(flow1, r[2].timestamp)
+                   / 60000000.0f;
+    state.volume_2 = state.volumeInt[1].update(flow2, r[3].timestamp)
+                   / 60000000.0f;
+
+    #ifndef LOG_PRINT
+    // Log data at each update step
+    if(state.enabled || (tail > 0))
+    {
+        loggerSample_t sample;
+        sample.timestamp = trigger / 1000;
+        sample.pressure  = state.press_1;
+        sample.flow1     = state.flow_1;
+        sample.flow2     = state.flow_2;
+        sample.volume1   = state.volume_1;
+        sample.volume2   = state.volume_2;
+        sample.valves    = (hpOutputs::out_2::value() << 1)
+                         |  hpOutputs::out_1::value();
+
+        logRecord_t records[2];
+        size_t count = encoder.encode(sample, records);
+        for(size_t i = 0; i < count; i++)
+            state.log.push(records[i], true);
+
+        // Sampling tail, 2s
+        if(state.enabled || (sample.valves != 0))
+            tail = 50;
         else
-        {
-            // Update flow measurements
-            state.flow1_raw  = sensors.getRawValue(Sensor::FLOW_1);
-            state.flow1_out  = sensors.getVoltage(Sensor::FLOW_1);
-            state.flow_1     = sensors.getValue(Sensor::FLOW_1);
-
-            state.flow2_raw  = sensors.getRawValue(Sensor::FLOW_2);
-            state.flow2_out  = sensors.getVoltage(Sensor::FLOW_2);
-            state.flow_2     = sensors.getValue(Sensor::FLOW_2);
-
-            // Flow rate is in l/min while update step is in ms, hence we have
-            // to divide the flow rate by 60 s/min * 1000 ms/s.
-            //
-            // Update volumes only if valve controller is running and flow
-            // measurements contain valid data.
-            if(state.enabled)
-            {
-                if(std::isnan(state.flow_1) == false)
-                {
-                    state.volume_1 += (state.flow_1 / 60000.0f)
-                                    * static_cast< float > (updateStep);
-                }
-
-                if(std::isnan(state.flow_2) == false)
-                {
-                    state.volume_2 += (state.flow_2 / 60000.0f)
-                                    * static_cast< float > (updateStep);
-                }
-            }
-
-            // Preset input multiplexer for next turn;
-            sensors.selectInput(Sensor::PRESS_1);
-        }
-
-        if(state.resetVolumes)
-        {
-            state.volume_1 = 0.0f;
-            state.volume_2 = 0.0f;
-            state.resetVolumes = false;
-        }
-
-        #ifndef LOG_PRINT
-        // Log data at each update step
-        if(state.enabled || (tail > 0))
-        {
-            loggerSample_t sample;
-            sample.timestamp = getTick();
-            sample.pressure  = state.press_1;
-            sample.flow1     = state.flow_1;
-            sample.flow2     = state.flow_2;
-            sample.volume1   = state.volume_1;
-            sample.volume2   = state.volume_2;
-            sample.valves    = (hpOutputs::out_2::value() << 1)
-                             |  hpOutputs::out_1::value();
-
-            state.log.push(sample, true);
-
-            // Sampling tail, 2s
-            if(state.enabled || (sample.valves != 0))
-                tail = 50;
-            else
-                tail -= 1;
-        }
-        #else
-        printf("%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d\n",
-                getTick(),                 state.press_1,
-                state.flow_1,              state.flow_2,
-                state.volume_1,            state.volume_2,
-                hpOutputs::out_1::value(), hpOutputs::out_2::value());
-        #endif
-
-        turn += 1;
-        time += updateStep;
-        Thread::sleepUntil(time);
+            tail -= 1;
     }
+    #else
+    printf("%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d\n",
+            getTick(),                 state.press_1,
+            state.flow_1,              state.flow_2,
+            state.volume_1,            state.volume_2,
+            hpOutputs::out_1::value(), hpOutputs::out_2::value());
+    #endif
+
+    if(onUpdate) onUpdate();
 }
 
+void SensorSampler::updateJitter(const uint32_t latency)
+{
+    size_t bin = 0;
+    while(latency > jitterLimits[bin])
+        bin++;
+
+    histogram[bin] += 1;
+
+    if(latency > maxLatency)
+        maxLatency = latency;
+}
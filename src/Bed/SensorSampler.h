@@ -18,12 +18,14 @@
 
 #pragma once
 
+#include <functional>
 #include "common/ActiveObject.h"
 #include "drivers/hwmapping.h"
 #include "drivers/ADC122S021.h"
 #include "drivers/FSP2000.h"
 #include "drivers/FS1015CL.h"
 #include "AnalogSensors.h"
+#include "LogFormat.h"
 
 /**
  * Sensor sampler class for collecting all the measurements, active object.
@@ -42,6 +44,57 @@ public:
      */
     virtual ~SensorSampler();
 
+    /**
+     * Get the histogram of the sampler wakeup latency, measured as the time
+     * elapsed between the timer trigger and the moment the sampler thread
+     * starts running.
+     *
+     * @param counts: buffer for the histogram, must have room for
+     * NUM_JITTER_BINS elements.
+     */
+    void getJitterHistogram(uint32_t *counts) const;
+
+    /**
+     * Get the upper limit of a bin of the latency histogram.
+     *
+     * @param bin: bin index.
+     * @return bin upper limit in us, UINT32_MAX for the last bin.
+     */
+    static uint32_t jitterBinLimit(const size_t bin);
+
+    /**
+     * @return maximum wakeup latency measured so far, in us.
+     */
+    uint32_t maxJitter() const { return maxLatency; }
+
+    /**
+     * @return number of update steps started after the following trigger.
+     */
+    uint32_t overruns() const { return numOverruns; }
+
+    /**
+     * Set a function to be called at the end of each update step, once the
+     * new measurements are available. Must be called before starting the
+     * sampler thread.
+     *
+     * @param callback: function to be called, runs in the sampler thread.
+     */
+    void setUpdateCallback(const std::function< void() >& callback)
+    {
+        onUpdate = callback;
+    }
+
+    /**
+     * Perform one update step: sample all the sensors, update the state
+     * variables and the volume integrals and log the new measurements. Called
+     * by the sampler thread once every update period.
+     *
+     * @param trigger: time at which the step has been triggered, in us.
+     */
+    void step(const unsigned long long trigger);
+
+    static constexpr size_t NUM_JITTER_BINS = 8;    ///< Latency histogram size
+
 private:
 
     /**
@@ -50,6 +103,21 @@ private:
      */
     virtual void run() override;
 
-    static constexpr uint32_t updateStep = 40;  ///< 40ms update step (25Hz)
-    AnalogSensors&            sensors;          ///< Analog sensors manager
+    /**
+     * Update the latency statistics.
+     *
+     * @param latency: wakeup latency of the last update step, in us.
+     */
+    void updateJitter(const uint32_t latency);
+
+    static constexpr uint32_t updateStep   = 40;  ///< 40ms update step (25Hz)
+    static constexpr uint8_t  TIMER_CHANNEL = 1;  ///< Sample timer channel
+
+    AnalogSensors&    sensors;                    ///< Analog sensors manager
+    LogEncoder        encoder;                    ///< Log records encoder
+    volatile uint32_t histogram[NUM_JITTER_BINS]; ///< Latency histogram
+    volatile uint32_t maxLatency;                 ///< Maximum latency, in us
+    volatile uint32_t numOverruns;                ///< Late update steps
+    uint8_t           tail;                       ///< Remaining log tail steps
+    std::function< void() > onUpdate;             ///< Update step callback
 };
@@ -69,25 +69,35 @@ BedCalibSensors::~BedCalibSensors()
 
 void BedCalibSensors::enter()
 {
+    fsm->dc.clear(lightGrey);
+    fsm->dc.setTextColor(black, lightGrey);
+
+    unsigned int txtOffset = (btnHeight - droid21.getHeight()) / 2;
+    Point txt1(10, zero[0]->getUpperLeftCorner().y() + txtOffset);
+    fsm->dc.write(txt1, "Set zero");
+
+    Point txt2(10, max[0]->getUpperLeftCorner().y() + txtOffset);
+    fsm->dc.write(txt2, "Set max");
+
+    for(int i = 0; i < 3; i++)
+    {
+        lines[i].clear();
+        zero[i]->invalidate();
+        max[i]->invalidate();
+    }
 
+    back->invalidate();
+    reset->invalidate();
 }
 
 FsmState *BedCalibSensors::update()
 {
-    fsm->dc.clear(lightGrey);
     fsm->dc.setTextColor(black, lightGrey);
 
     writeLine(0, "P1", state.press1_raw, state.press_1);
     writeLine(1, "F1", state.flow1_raw,  state.flow_1);
     writeLine(2, "F2", state.flow2_raw,  state.flow_2);
 
-    unsigned int txtOffset = (btnHeight - droid21.getHeight()) / 2;
-    Point txt1(10, zero[0]->getUpperLeftCorner().y() + txtOffset);
-    fsm->dc.write(txt1, "Set zero");
-
-    Point txt2(10, max[0]->getUpperLeftCorner().y() + txtOffset);
-    fsm->dc.write(txt2, "Set max");
-
     Event     event    = InputHandler::instance().popEvent();
     FsmState *nxtState = nullptr;
     bool     updateCal = false;
@@ -203,14 +213,22 @@ void BedCalibSensors::leave()
 void BedCalibSensors::writeLine(const int pos, const char* label,
                                 const uint16_t raw, const float conv)
 {
-    char str[32];
-    const int yPos = (droid21.getHeight() + 5) * pos;
+    char str1[32];
+    char str2[32];
+    snprintf(str1, sizeof(str1), "%s   raw: %d", label, raw);
+    snprintf(str2, sizeof(str2), "conv: %.2f", conv);
 
-    Point p1(10, 10 + yPos);
-    snprintf(str, sizeof(str), "%s   raw: %d", label, raw);
-    fsm->dc.write(p1, str);
+    // Redraw the line only if its content changed
+    std::string line = std::string(str1) + '\n' + str2;
+    if(line == lines[pos]) return;
+    lines[pos] = line;
 
+    const int yPos = (droid21.getHeight() + 5) * pos;
+    Point p1(10, 10 + yPos);
     Point p2(p1.x() + (fsm->dc.getWidth() - 20)/2, p1.y());
-    snprintf(str, sizeof(str), "conv: %.2f", conv);
-    fsm->dc.write(p2, str);
+
+    fsm->dc.clear(p1, Point(fsm->dc.getWidth() - 1,
+                            p1.y() + droid21.getHeight() - 1), lightGrey);
+    fsm->dc.write(p1, str1);
+    fsm->dc.write(p2, str2);
 }
@@ -74,6 +74,7 @@ private:
     std::unique_ptr< Button > reset;
     std::unique_ptr< Button > back;
 
+    std::string lines[3];   // Sensor lines currently on screen
     int sensorToUpdate;
 
     BedFsmData* fsm;
@@ -64,6 +64,11 @@ BedMainPage::~BedMainPage() { }
 void BedMainPage::enter()
 {
     fsm->dc.clear(uiBkgColor);
+    statusBox->invalidate();
+    enable->invalidate();
+    disable->invalidate();
+    setup->invalidate();
+    calib->invalidate();
 }
 
 FsmState *BedMainPage::update()
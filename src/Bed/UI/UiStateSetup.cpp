@@ -53,6 +53,10 @@ BedSetupPage::~BedSetupPage() { }
 void BedSetupPage::enter()
 {
     fsm->dc.clear(uiBkgColor);
+    setTin->invalidate();
+    setIE->invalidate();
+    setFs->invalidate();
+    ret->invalidate();
 }
 
 FsmState *BedSetupPage::update()
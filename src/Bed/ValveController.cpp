@@ -23,7 +23,10 @@
 using namespace std;
 using namespace miosix;
 
-ValveController::ValveController(StateData& state) : state(state)
+ValveController::ValveController(StateData& state) : state(state),
+                                                     phase(Phase::IDLE),
+                                                     tIns(0), tEsp(0),
+                                                     led(false)
 {
     hpOutputs::out_1::mode(Mode::OUTPUT);
     hpOutputs::out_2::mode(Mode::OUTPUT);
@@ -41,48 +44,64 @@ ValveController::~ValveController()
 
 void ValveController::run()
 {
-    while(1)
+    while(shouldStop() == false)
+        Thread::sleep(step());
+}
+
+uint32_t ValveController::step()
+{
+    switch(phase)
     {
-        if((state.enabled) && (state.tIns > 0) && (state.IE > 0))
-        {
-            uint32_t tIns = static_cast< uint32_t >(state.tIns * 1000.0f);
-            uint32_t tEsp = static_cast< uint32_t >(state.tIns * state.IE
-                                                               * 1000.0f);
+        case Phase::IDLE:
+        case Phase::EXPIRATION:
+            // End of a cycle, check if a new one has to be started
+            if((state.enabled) && (state.tIns > 0) && (state.IE > 0))
+            {
+                tIns = static_cast< uint32_t >(state.tIns * 1000.0f);
+                tEsp = static_cast< uint32_t >(state.tIns * state.IE
+                                                          * 1000.0f);
+
+                // Force EV1 and EV2 to closed state, wait 50ms to compensate
+                // for valve closing time.
+                hpOutputs::out_1::low();
+                hpOutputs::out_2::low();
+                phase = Phase::PAUSE_INS;
+                return 50;
+            }
 
-            // Force EV1 and EV2 to closed state, wait 50ms to compensate for
-            // valve closing time. Reset inh/exh. volume measurements before a
-            // new cycle begins.
             hpOutputs::out_1::low();
             hpOutputs::out_2::low();
-            Thread::sleep(50);
-            state.resetVolumes = true;
 
-            // Open EV1
+            led = !led;
+            led ? miosix::ledOn() : miosix::ledOff();
+            phase = Phase::IDLE;
+            return 50;
+
+        case Phase::PAUSE_INS:
+            // Reset inh/exh. volume measurements before a new cycle begins,
+            // then open EV1
+            state.volumeInt[0].requestReset();
+            state.volumeInt[1].requestReset();
             hpOutputs::out_1::high();
             miosix::ledOn();
-            Thread::sleep(tIns);
+            phase = Phase::INSPIRATION;
+            return tIns;
 
+        case Phase::INSPIRATION:
             // Force EV1 and EV2 to closed state, wait 50ms to compensate for
             // valve closing time.
             hpOutputs::out_1::low();
             hpOutputs::out_2::low();
-            Thread::sleep(50);
+            phase = Phase::PAUSE_EXP;
+            return 50;
 
+        case Phase::PAUSE_EXP:
             // Open EV2
             hpOutputs::out_2::high();
             miosix::ledOff();
-            Thread::sleep(tEsp);
-        }
-        else
-        {
-            hpOutputs::out_1::low();
-            hpOutputs::out_2::low();
-
-            miosix::ledOn();
-            Thread::sleep(50);
-            miosix::ledOff();
-            Thread::sleep(50);
-        }
+            phase = Phase::EXPIRATION;
+            return tEsp;
     }
-}
 
+    return 50;
+}
@@ -39,12 +39,40 @@ public:
      */
     virtual ~ValveController();
 
+    /**
+     * Advance the valve sequence by one phase, setting the valves accordingly.
+     * A breathing cycle is made of four phases: pause with both valves closed,
+     * inspiration with EV1 open, pause and expiration with EV2 open. Changes
+     * of the cycle parameters are applied at the beginning of a new cycle.
+     * When the controller is disabled both valves are kept closed.
+     *
+     * @return duration of the phase just started, in ms.
+     */
+    uint32_t step();
+
 private:
 
     /**
-     *
+     * Valve sequence phases.
+     */
+    enum class Phase : uint8_t
+    {
+        IDLE,           ///< Controller disabled, valves closed.
+        PAUSE_INS,      ///< Both valves closed before inspiration.
+        INSPIRATION,    ///< EV1 open.
+        PAUSE_EXP,      ///< Both valves closed before expiration.
+        EXPIRATION      ///< EV2 open.
+    };
+
+    /**
+     * Worker function of the valve controller, called by the active object
+     * thread.
      */
     virtual void run() override;
 
     StateData& state;
+    Phase      phase;   ///< Current phase of the valve sequence
+    uint32_t   tIns;    ///< Inspiration time of the current cycle, in ms
+    uint32_t   tEsp;    ///< Expiration time of the current cycle, in ms
+    bool       led;     ///< Status led blinking state when disabled
 };
@@ -0,0 +1,69 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include "common/Persistence.h"
+#include "BjState.h"
+
+/**
+ * \internal
+ * Bell jar settings, as saved in flash memory. The tuning parameters come
+ * first, as they were saved alone before the gain scheduling table.
+ */
+struct BjSettings
+{
+    PidParameters params;
+    GainSchedule  schedule;
+};
+
+static_assert(sizeof(BjSettings) <= MAX_DATA_SIZE,
+              "Bell jar settings exceed the flash data block size");
+
+bool loadBjSettings()
+{
+    BjSettings settings;
+
+    if(loadDataFromFlash(&settings, sizeof(BjSettings)) &&
+       settings.schedule.isConsistent())
+    {
+        bjState.ctParams   = settings.params;
+        bjState.ctSchedule = settings.schedule;
+        return true;
+    }
+
+    // Legacy data, tuning parameters only
+    if(loadDataFromFlash(&bjState.ctParams, sizeof(PidParameters)))
+    {
+        bjState.ctSchedule.clear();
+        bjState.ctSchedule.mode = GainSchedule::OFF;
+        return true;
+    }
+
+    return false;
+}
+
+void saveBjSettings()
+{
+    // Clear the padding too, identical settings give identical blocks
+    BjSettings settings;
+    memset(static_cast< void * >(&settings), 0, sizeof(BjSettings));
+    settings.params   = bjState.ctParams;
+    settings.schedule = bjState.ctSchedule;
+
+    saveDataToFlash(&settings, sizeof(BjSettings));
+}
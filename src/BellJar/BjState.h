@@ -20,17 +20,21 @@
 
 #include <cstdint>
 #include "common/PidRegulator.h"
+#include "common/GainSchedule.h"
+#include "common/RelayAutotuner.h"
 
 enum class CtrlMode : uint8_t
 {
     MAN  = 0,
-    AUTO = 1
+    AUTO = 1,
+    TUNE = 2
 };
 
 struct BjState
 {
     CtrlMode      ctMode;           ///< Controller operating mode
     PidParameters ctParams;         ///< Controller tuning parameters
+    GainSchedule  ctSchedule;       ///< Controller gain scheduling table
     float         ctSetPoint;       ///< Controller set point
     float         ctOutput;         ///< Controller output
     float         manOutput;        ///< Output value for manual mode
@@ -40,6 +44,28 @@ struct BjState
     float         levelNorm;       ///< Normalised value of BJ level in range 0.0 - 1.0
     uint16_t      zeroLevel;       ///< Raw value in ADC counts correspoding to BJ zero level
     uint16_t      maxLevel;        ///< Raw value in ADC counts correspoding to BJ max level
+
+    RelayAutotuner::Status tuneStatus;  ///< Status of the last autotuning
+    float         tuneKu;           ///< Ultimate gain found by the autotuning
+    float         tuneTu;           ///< Ultimate period found by the autotuning
+    float         tuneLevel;        ///< Level of the autotuning experiment
+    PidParameters tuneParams;       ///< Tuning proposed by the autotuning
 };
 
 extern BjState bjState;
+
+/**
+ * Load the controller tuning parameters and the gain scheduling table from
+ * the flash memory. Data saved before the introduction of the gain scheduling,
+ * made of the tuning parameters only, is loaded with an empty table.
+ *
+ * @return true on success, false in case of corrupted data or non-initialized
+ * flash storage.
+ */
+bool loadBjSettings();
+
+/**
+ * Save the controller tuning parameters and the gain scheduling table to the
+ * flash memory.
+ */
+void saveBjSettings();
@@ -23,11 +23,97 @@
 using namespace std;
 using namespace miosix;
 
+constexpr float LevelController::RELAY_AMPLITUDE;
+constexpr float LevelController::RELAY_HYSTERESIS;
+
 LevelController::LevelController() : adc(ADC122S021::instance()),
                                      blower(Blower::instance()),
-                                     pid(bjState.ctParams), rMode(bjState.ctMode)
+                                     pid(bjState.ctParams),
+                                     rMode(bjState.ctMode),
+                                     relayCenter(bjState.ctSetPoint)
+{
+    bjState.tuneStatus = RelayAutotuner::Status::IDLE;
+    enterMode(rMode);
+}
+
+LevelController::~LevelController()
+{
+
+}
+
+void LevelController::run()
+{
+    unsigned long long time = getTick();
+
+    while(shouldStop() == false)
+    {
+        step();
+
+        time += static_cast< uint32_t >(bjState.ctParams.Tsample * 1000.0f);
+        Thread::sleepUntil(time);
+    }
+}
+
+void LevelController::step()
+{
+    updateMeasurements();
+
+    // Handle switching between man/auto/tune operating mode
+    if(rMode != bjState.ctMode)
+    {
+        // Leaving the tune mode before the end stops the experiment
+        if(tuner.status() == RelayAutotuner::Status::RUNNING)
+        {
+            tuner.abort();
+            bjState.tuneStatus = tuner.status();
+        }
+
+        // From manual mode, the relay switches around the current level,
+        // otherwise around the set point. The set point itself is left alone.
+        if(bjState.ctMode == CtrlMode::TUNE)
+        {
+            relayCenter = (rMode == CtrlMode::MAN) ? bjState.levelNorm
+                                                   : bjState.ctSetPoint;
+        }
+
+        rMode = bjState.ctMode;
+        enterMode(rMode);
+    }
+
+    // Apply the new tuning parameters, if changed. With gain scheduling, they
+    // follow the level or the set point and change is bumpless.
+    PidParameters params = bjState.ctParams;
+    if(bjState.ctSchedule.isActive())
+    {
+        float x = (bjState.ctSchedule.mode == GainSchedule::LEVEL)
+                ? bjState.levelNorm : bjState.ctSetPoint;
+        params  = bjState.ctSchedule.interpolate(bjState.ctParams, x);
+    }
+
+    if(pid.getParameters() != params)
+        pid.setParameters(params);
+
+    // Update tracking output, if in manual mode
+    if(bjState.ctMode == CtrlMode::MAN)
+        pid.setTrackingOutput(bjState.manOutput);
+
+    // Relay experiment drives the output through the tracking mode
+    if(bjState.ctMode == CtrlMode::TUNE)
+        stepTuning();
+
+    // Controller step
+    bjState.ctOutput = pid.computeAction(bjState.ctSetPoint,
+                                         bjState.levelNorm);
+
+    // Update actuation
+    blower.setValue(bjState.ctOutput);
+
+    if(onUpdate) onUpdate();
+}
+
+void LevelController::enterMode(const CtrlMode mode)
 {
-    switch(rMode)
+    switch(mode)
     {
         case CtrlMode::MAN:
             pid.enableTracking();
@@ -37,6 +123,16 @@ LevelController::LevelController() : adc(ADC122S021::instance()),
             pid.disableTracking();
             break;
 
+        case CtrlMode::TUNE:
+            // The relay switches around the output of the last step, the
+            // bell jar should be steady close to the set point.
+            pid.enableTracking();
+            tuner.start(bjState.ctOutput, RELAY_AMPLITUDE, RELAY_HYSTERESIS,
+                        bjState.ctParams.Tsample, bjState.ctParams.uMin,
+                        bjState.ctParams.uMax);
+            bjState.tuneStatus = tuner.status();
+            break;
+
         default:
             // UH-OH!
             assert(false);
@@ -44,55 +140,27 @@ LevelController::LevelController() : adc(ADC122S021::instance()),
     }
 }
 
-LevelController::~LevelController()
+void LevelController::stepTuning()
 {
+    float u = tuner.step(relayCenter, bjState.levelNorm);
+    pid.setTrackingOutput(u);
 
-}
-
-void LevelController::run()
-{
-    unsigned long long time = getTick();
+    if(tuner.status() == RelayAutotuner::Status::RUNNING)
+        return;
 
-    while(1)
+    // Experiment over: publish the results and go back to manual mode,
+    // holding the relay bias.
+    if(tuner.status() == RelayAutotuner::Status::DONE)
     {
-        updateMeasurements();
-
-        // Handle switching between man/auto operating mode
-        if(rMode != bjState.ctMode)
-        {
-            switch(bjState.ctMode)
-            {
-                case CtrlMode::MAN:
-                    pid.enableTracking();
-                    break;
-
-                case CtrlMode::AUTO:
-                    pid.disableTracking();
-                    break;
-
-                default:
-                    // UH-OH!
-                    assert(false);
-                    break;
-            }
-
-            rMode = bjState.ctMode;
-        }
-
-        // Update tracking output, if in manual mode
-        if(bjState.ctMode == CtrlMode::MAN)
-            pid.setTrackingOutput(bjState.manOutput);
-
-        // Controller step
-        bjState.ctOutput = pid.computeAction(bjState.ctSetPoint,
-                                             bjState.levelNorm);
-
-        // Update actuation
-        blower.setValue(bjState.ctOutput);
-
-        time += static_cast< uint32_t >(bjState.ctParams.Tsample * 1000.0f);
-        Thread::sleepUntil(time);
+        bjState.tuneKu     = tuner.ultimateGain();
+        bjState.tuneTu     = tuner.ultimatePeriod();
+        bjState.tuneLevel  = relayCenter;
+        bjState.tuneParams = tuner.proposal(bjState.ctParams);
     }
+
+    bjState.manOutput  = u;
+    bjState.tuneStatus = tuner.status();
+    bjState.ctMode     = CtrlMode::MAN;
 }
 
 void LevelController::updateMeasurements()
@@ -18,8 +18,10 @@
 
 #pragma once
 
+#include <functional>
 #include "common/ActiveObject.h"
 #include "common/PidRegulator.h"
+#include "common/RelayAutotuner.h"
 #include "drivers/ADC122S021.h"
 #include "drivers/Blower.h"
 #include "BellJar/BjState.h"
@@ -41,10 +43,30 @@ public:
      */
     virtual ~LevelController();
 
+    /**
+     * Set a function to be called at the end of each controller step. Must be
+     * called before starting the controller thread.
+     *
+     * @param callback: function to be called, runs in the controller thread.
+     */
+    void setUpdateCallback(const std::function< void() >& callback)
+    {
+        onUpdate = callback;
+    }
+
+    /**
+     * Perform one controller step: update the level measurement, handle the
+     * switching between operating modes and the changes of the tuning
+     * parameters, gain scheduling included, and apply the new control action.
+     * In tune mode, the control action comes from the relay autotuner.
+     * Called by the controller thread once every sample period.
+     */
+    void step();
+
 private:
 
     /**
-     * Worker function of the sensor sampler, called by the active object
+     * Worker function of the level controller, called by the active object
      * thread.
      */
     virtual void run() override;
@@ -54,9 +76,27 @@ private:
      */
     void updateMeasurements();
 
+    /**
+     * Set up the regulator for a new operating mode.
+     *
+     * @param mode: new operating mode.
+     */
+    void enterMode(const CtrlMode mode);
+
+    /**
+     * Perform one step of the relay experiment and, once it is over, publish
+     * its results and switch back to manual mode.
+     */
+    void stepTuning();
+
+    static constexpr float RELAY_AMPLITUDE  = 0.1f;   ///< Relay amplitude
+    static constexpr float RELAY_HYSTERESIS = 0.01f;  ///< Relay hysteresis
 
-    ADC122S021&  adc;    ///< ADC driver.
-    Blower&      blower; ///< Blower controller
-    PidRegulator pid;    ///< PID regulator
-    CtrlMode     rMode;  ///< Current regulator's operating mode
+    ADC122S021&    adc;    ///< ADC driver.
+    Blower&        blower; ///< Blower controller
+    PidRegulator   pid;    ///< PID regulator
+    RelayAutotuner tuner;  ///< Relay autotuner
+    CtrlMode       rMode;  ///< Current regulator's operating mode
+    float          relayCenter;  ///< Level the relay switches around
+    std::function< void() > onUpdate;  ///< Controller step callback
 };
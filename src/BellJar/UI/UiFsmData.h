@@ -28,6 +28,8 @@
 #include "UiStateConfSp.h"
 #include "UiStateConfigPid.h"
 #include "UiStateConfigInput.h"
+#include "UiStateConfTune.h"
+#include "UiStateTuneResult.h"
 
 class BjFsmData
 {
@@ -37,7 +39,7 @@ public:
                   kbInput(std::numeric_limits< float >::quiet_NaN()),
                   mainPage(this),   inputVal(this),   confirmAut(this),
                   confirmMan(this), confirmSp(this), setupPid(this),
-                  setupInput(this) { }
+                  setupInput(this), confirmTune(this), tuneResult(this) { }
 
     mxgui::DrawingContext dc;
     float kbInput;
@@ -50,4 +52,6 @@ public:
     BjConfirmSp   confirmSp;
     BjConfigPid   setupPid;
     BjConfigInput setupInput;
+    BjConfirmTune confirmTune;
+    BjTuneResult  tuneResult;
 };
@@ -0,0 +1,60 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include "UiStateConfTune.h"
+#include "UiFsmData.h"
+
+using namespace mxgui;
+using namespace std;
+
+BjConfirmTune::BjConfirmTune(BjFsmData* fsm) : fsm(fsm)
+{
+    int cBox_x = (fsm->dc.getWidth()  - ConfirmBox::getWidth())/2;
+    int cBox_y = (fsm->dc.getHeight() - ConfirmBox::getHeight())/2;
+    cBox = make_unique< ConfirmBox >(cBox_x, cBox_y);
+}
+
+BjConfirmTune::~BjConfirmTune() { }
+
+void BjConfirmTune::enter()
+{
+    fsm->dc.clear(lightGrey);
+    cBox->draw(fsm->dc, "Start relay\nautotuning?");
+}
+
+FsmState *BjConfirmTune::update()
+{
+    Event event = InputHandler::instance().popEvent();
+    if(cBox->handleEvent(event, fsm->dc))
+    {
+        // The relay switches around the current output and level, the
+        // results are shown once the experiment is over.
+        if(cBox->confirmed())
+        {
+            bjState.ctMode = CtrlMode::TUNE;
+            return &fsm->mainPage;
+        }
+
+        return &fsm->setupPid;
+    }
+
+    return nullptr;
+}
+
+void BjConfirmTune::leave() { }
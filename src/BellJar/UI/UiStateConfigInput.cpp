@@ -65,13 +65,16 @@ BjConfigInput::~BjConfigInput()
 
 void BjConfigInput::enter()
 {
-
+    fsm->dc.clear(lightGrey);
+    levels->invalidate();
+    zero->invalidate();
+    max->invalidate();
+    ret->invalidate();
+    nxt->invalidate();
 }
 
 FsmState *BjConfigInput::update()
 {
-    fsm->dc.clear(lightGrey);
-
     char str[32];
     snprintf(str, sizeof(str), "%d", bjState.levelRaw);
     levels->setEntryValue(0, str, black);
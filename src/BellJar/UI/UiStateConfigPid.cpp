@@ -18,7 +18,6 @@
 
 #include <array>
 #include <memory>
-#include "common/Persistence.h"
 #include "UiStateConfigPid.h"
 #include "UiFsmData.h"
 
@@ -29,21 +28,25 @@ BjConfigPid::BjConfigPid(BjFsmData* fsm) : valueToChange(-1), fsm(fsm)
 {
     int x = 0;
     int y = spacing;
-    entries.push_back( make_unique < CfgEntry< float > >(Point(x, y), "Kp",
+    int w = fsm->dc.getWidth();
+    entries.push_back( make_unique < CfgEntry< float > >(Point(x, y), w, "Kp",
                                                          bjState.ctParams.k));
     y += 38;
-    entries.push_back( make_unique < CfgEntry< float > >(Point(x, y), "Ti",
+    entries.push_back( make_unique < CfgEntry< float > >(Point(x, y), w, "Ti",
                                                          bjState.ctParams.Ti));
     y += 38;
-    entries.push_back( make_unique < CfgEntry< float > >(Point(x, y), "Td",
+    entries.push_back( make_unique < CfgEntry< float > >(Point(x, y), w, "Td",
                                                          bjState.ctParams.Td));
     y += 38;
-    entries.push_back( make_unique < CfgEntry< float > >(Point(x, y), "N",
+    entries.push_back( make_unique < CfgEntry< float > >(Point(x, y), w, "N",
                                                          bjState.ctParams.N));
     y += 38;
-    entries.push_back( make_unique < CfgEntry< float > >(Point(x, y), "Ts",
+    entries.push_back( make_unique < CfgEntry< float > >(Point(x, y), w, "Ts",
                                                          bjState.ctParams.Tsample));
     entries.shrink_to_fit();
+    y += 38;
+    sched = make_unique < CfgEntry< uint8_t > >(Point(x, y), w, "Sched",
+                                                bjState.ctSchedule.mode);
 
     unsigned int bWidth = (fsm->dc.getWidth() - (2*spacing + btnSpace))/2;
     unsigned int bx = spacing;
@@ -51,6 +54,10 @@ BjConfigPid::BjConfigPid(BjFsmData* fsm) : valueToChange(-1), fsm(fsm)
 
     ret = make_unique< Button >(Point(bx, by), bWidth, btnHeight, "Back",
                                  droid21);
+
+    bx   = fsm->dc.getWidth() - spacing - bWidth;
+    tune = make_unique< Button >(Point(bx, by), bWidth, btnHeight, "Tune",
+                                 droid21);
 }
 
 BjConfigPid::~BjConfigPid()
@@ -61,6 +68,10 @@ BjConfigPid::~BjConfigPid()
 void BjConfigPid::enter()
 {
     fsm->dc.clear(lightGrey);
+    for(auto& entry : entries) entry->invalidate();
+    sched->invalidate();
+    ret->invalidate();
+    tune->invalidate();
 }
 
 FsmState *BjConfigPid::update()
@@ -89,6 +100,22 @@ FsmState *BjConfigPid::update()
                 bjState.ctParams.Tsample = fsm->kbInput;
                 break;
 
+            // Gain scheduling: 0 off, 1 on level, 2 on set point. A negative
+            // value switches it off and clears the table.
+            case 5:
+                if((fsm->kbInput >= 0.0f) &&
+                   (fsm->kbInput <= GainSchedule::SET_POINT))
+                {
+                    bjState.ctSchedule.mode = static_cast< uint8_t >
+                                              (fsm->kbInput);
+                }
+                else if(fsm->kbInput < 0.0f)
+                {
+                    bjState.ctSchedule.mode = GainSchedule::OFF;
+                    bjState.ctSchedule.clear();
+                }
+                break;
+
             default:
                 break;
         }
@@ -106,6 +133,9 @@ FsmState *BjConfigPid::update()
         if(pressed) valueToChange = i;
     }
 
+    if(sched->update(event, fsm->dc))
+        valueToChange = entries.size();
+
     if(valueToChange >= 0)
     {
         fsm->prevState = this;
@@ -113,13 +143,15 @@ FsmState *BjConfigPid::update()
     }
 
     bool retPressed  = ret->handleTouchEvent(event);
+    bool tunePressed = tune->handleTouchEvent(event);
     ret->draw(fsm->dc);
+    tune->draw(fsm->dc);
 
-    if(retPressed)
-    {
-        saveDataToFlash(&bjState.ctParams, sizeof(PidParameters));
-        nxtState = &fsm->setupInput;
-    }
+    if(retPressed || tunePressed)
+        saveBjSettings();
+
+    if(retPressed)  nxtState = &fsm->setupInput;
+    if(tunePressed) nxtState = &fsm->confirmTune;
 
     return nxtState;
 }
@@ -68,7 +68,9 @@ private:
 
     int valueToChange;
     std::vector< std::unique_ptr< CfgEntry< float > > > entries;
+    std::unique_ptr< CfgEntry< uint8_t > > sched;
     std::unique_ptr< Button > ret;
+    std::unique_ptr< Button > tune;
 
     BjFsmData* fsm;
 };
@@ -39,6 +39,7 @@ void BjInputValue::enter()
 {
     fsm->dc.clear(lightGrey);
     kb->clear();
+    kb->invalidate();
     kb->draw(fsm->dc);
 }
 
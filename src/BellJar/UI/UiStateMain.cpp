@@ -63,6 +63,11 @@ BjMainPage::~BjMainPage() { }
 void BjMainPage::enter()
 {
     fsm->dc.clear(uiBkgColor);
+    statusBox->invalidate();
+    man->invalidate();
+    aut->invalidate();
+    set->invalidate();
+    conf->invalidate();
 }
 
 FsmState *BjMainPage::update()
@@ -79,8 +84,8 @@ FsmState *BjMainPage::update()
 
     char str[32];
 
-    // Print set-point value
-    if(bjState.ctMode == CtrlMode::AUTO)
+    // Print set-point value, the relay experiment runs around it too
+    if(bjState.ctMode != CtrlMode::MAN)
     {
         snprintf(str, sizeof(str), "%d",
                 static_cast< int > (bjState.ctSetPoint * 100.0f));
@@ -113,6 +118,10 @@ FsmState *BjMainPage::update()
             statusBox->setEntryValue(3, "AUTO", blue);
             break;
 
+        case CtrlMode::TUNE:
+            statusBox->setEntryValue(3, "TUNE", green);
+            break;
+
         default:
             statusBox->setEntryValue(3, " ", black);
             break;
@@ -131,6 +140,13 @@ FsmState *BjMainPage::update()
 
     if(cnfPressed) return &fsm->setupInput;
 
+    // Relay experiment over, show its results
+    if((bjState.tuneStatus == RelayAutotuner::Status::DONE) ||
+       (bjState.tuneStatus == RelayAutotuner::Status::FAILED))
+    {
+        return &fsm->tuneResult;
+    }
+
     return nullptr;
 }
 
@@ -0,0 +1,130 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include "UiStateTuneResult.h"
+#include "UiFsmData.h"
+
+using namespace mxgui;
+using namespace std;
+
+const vector< string > BjTuneResult::labels =
+{
+    "Autotuning",
+    "Ku",
+    "Tu",
+    "Kp",
+    "Ti",
+    "Td"
+};
+
+BjTuneResult::BjTuneResult(BjFsmData* fsm) : fsm(fsm)
+{
+    results = make_unique< DisplayBox >(Point(0, 0), fsm->dc.getWidth(), 190,
+                                        10, fsm->dc.getWidth()/2, labels,
+                                        lightGrey, black, droid21);
+
+    unsigned int bWidth = (fsm->dc.getWidth() - (2*spacing + btnSpace))/2;
+    unsigned int bx = spacing;
+    unsigned int by = fsm->dc.getHeight() - spacing - btnHeight;
+
+    discard = make_unique< Button >(Point(bx, by), bWidth, btnHeight,
+                                    "Discard", droid21);
+
+    bx    = fsm->dc.getWidth() - spacing - bWidth;
+    apply = make_unique< Button >(Point(bx, by), bWidth, btnHeight, "Apply",
+                                  droid21);
+}
+
+BjTuneResult::~BjTuneResult()
+{
+
+}
+
+void BjTuneResult::enter()
+{
+    fsm->dc.clear(lightGrey);
+    results->invalidate();
+    discard->invalidate();
+    apply->invalidate();
+}
+
+FsmState *BjTuneResult::update()
+{
+    bool done = (bjState.tuneStatus == RelayAutotuner::Status::DONE);
+
+    if(done)
+    {
+        char str[32];
+        results->setEntryValue(0, "Done", blue);
+
+        snprintf(str, sizeof(str), "%.3f", bjState.tuneKu);
+        results->setEntryValue(1, str, black);
+
+        snprintf(str, sizeof(str), "%.2f", bjState.tuneTu);
+        results->setEntryValue(2, str, black);
+
+        snprintf(str, sizeof(str), "%.3f", bjState.tuneParams.k);
+        results->setEntryValue(3, str, black);
+
+        snprintf(str, sizeof(str), "%.2f", bjState.tuneParams.Ti);
+        results->setEntryValue(4, str, black);
+
+        snprintf(str, sizeof(str), "%.2f", bjState.tuneParams.Td);
+        results->setEntryValue(5, str, black);
+    }
+    else
+    {
+        // No limit cycle found, nothing to propose
+        results->setEntryValue(0, "Failed", red);
+        for(int i = 1; i < 6; i++) results->setEntryValue(i, "-", black);
+    }
+
+    results->draw(fsm->dc);
+
+    Event event = InputHandler::instance().popEvent();
+    bool discardPressed = discard->handleTouchEvent(event);
+    bool applyPressed   = apply->handleTouchEvent(event);
+    discard->draw(fsm->dc);
+    apply->draw(fsm->dc);
+
+    // With gain scheduling enabled, the new tuning goes to the breakpoint
+    // nearest to the level of the experiment.
+    if(applyPressed && done)
+    {
+        if(bjState.ctSchedule.mode != GainSchedule::OFF)
+            bjState.ctSchedule.setPoint(bjState.tuneLevel, bjState.tuneParams);
+        else
+            bjState.ctParams = bjState.tuneParams;
+
+        saveBjSettings();
+    }
+
+    if(discardPressed || (applyPressed && done))
+    {
+        bjState.tuneStatus = RelayAutotuner::Status::IDLE;
+        return &fsm->mainPage;
+    }
+
+    return nullptr;
+}
+
+void BjTuneResult::leave()
+{
+
+}
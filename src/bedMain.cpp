@@ -21,13 +21,15 @@
 #include <cstdio>
 #include <unistd.h>
 #include "miosix.h"
+#include "filesystem/console/console_device.h"
 
 #include "Bed/ValveController.h"
 #include "Bed/SensorSampler.h"
 #include "Bed/AnalogSensors.h"
+#include "Bed/LogStream.h"
 #include "Bed/UI/UiFsmData.h"
 #include "common/Persistence.h"
-#include "common/RingBuffer.h"
+#include "common/SpscRingBuffer.h"
 #include "common/Fsm.h"
 
 using namespace std;
@@ -35,10 +37,136 @@ using namespace mxgui;
 using namespace miosix;
 
 StateData state;
+static loggerSample_t samples[256];
+
+/**
+ * \internal
+ * Print a block of log samples on the console, in CSV format.
+ *
+ * @param samples: pointer to the first sample.
+ * @param count: number of samples to print.
+ */
+static void printSamples(const loggerSample_t *samples, const size_t count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        const loggerSample_t& sample = samples[i];
+        printf("%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d\n",
+               sample.timestamp,       sample.pressure,
+               sample.flow1,           sample.flow2,
+               sample.volume1,         sample.volume2,
+              (sample.valves & 0x01), (sample.valves >> 1));
+    }
+}
+
+/**
+ * \internal
+ * Dump the log content in CSV format.
+ */
+static void dumpCsv()
+{
+    // Drain the log in chunks. Each chunk is copied out of the buffer and
+    // printed only if the producer did not overwrite it while being copied,
+    // otherwise it is dropped and the dump restarts from the new oldest record.
+    static logRecord_t records[256];
+    LogDecoder decoder;
+    decltype(state.log)::Span first, second;
+    size_t count;
+    while((count = state.log.readSpans(first, second, 256)) > 0)
+    {
+        memcpy(records, first.data, first.len * sizeof(logRecord_t));
+        memcpy(&records[first.len], second.data,
+               second.len * sizeof(logRecord_t));
+
+        if(state.log.commitRead(count) == false)
+        {
+            // The time base is lost together with the dropped records
+            decoder.reset();
+            continue;
+        }
+
+        size_t n = decoder.decode(records, count, samples);
+        printSamples(samples, n);
+    }
+}
+
+/**
+ * \internal
+ * Dump the log content as a framed binary stream, see LogStream.h. Frames are
+ * written directly to the console device, bypassing the terminal newline
+ * conversion.
+ */
+static void dumpBinary()
+{
+    static uint8_t frame[LOG_FRAME_MAX_SIZE];
+    auto console = DefaultConsole::instance().get();
+    LogFrameWriter writer;
+
+    fflush(stdout);
+
+    // The dump ends after the number of records present when it started, so
+    // that it terminates even while the sampler keeps logging. Chunks that the
+    // producer overwrote while being copied are dropped, and the next frame
+    // is flagged accordingly.
+    static logRecord_t records[LOG_FRAME_MAX_RECORDS];
+    decltype(state.log)::Span first, second;
+    size_t remaining = state.log.size();
+    bool   gap       = false;
+    bool   last      = false;
+    while(last == false)
+    {
+        // Take at most one frame worth of records. When the records wrap
+        // around the end of the buffer the second block is left for the next
+        // frame.
+        state.log.readSpans(first, second,
+                            min(remaining, LOG_FRAME_MAX_RECORDS));
+        size_t count = first.len;
+        memcpy(records, first.data, count * sizeof(logRecord_t));
+        remaining -= count;
+        last       = (remaining == 0) || (count == 0);
+
+        if(state.log.commitRead(count) == false)
+        {
+            gap = true;
+            if(last == false) continue;
+
+            // Close the dump with an empty frame
+            count = 0;
+        }
+
+        size_t size = writer.build(records, count, last, gap, frame);
+        console->writeBlock(frame, size, 0);
+        gap = false;
+    }
+}
+
+/**
+ * \internal
+ * Print the wakeup latency statistics of the sensor sampler.
+ */
+static void printJitter(const SensorSampler& sampler)
+{
+    uint32_t counts[SensorSampler::NUM_JITTER_BINS];
+    sampler.getJitterHistogram(counts);
+
+    for(size_t i = 0; i < SensorSampler::NUM_JITTER_BINS; i++)
+    {
+        uint32_t limit = SensorSampler::jitterBinLimit(i);
+        if(limit == UINT32_MAX)
+            printf(">%lu us: %lu\n", SensorSampler::jitterBinLimit(i - 1),
+                                     counts[i]);
+        else
+            printf("<=%lu us: %lu\n", limit, counts[i]);
+    }
+
+    printf("max: %lu us, overruns: %lu\n", sampler.maxJitter(),
+                                           sampler.overruns());
+}
 
 int main()
 {
-    state.resetVolumes = true;
+    state.volume_1     = 0.0f;
+    state.volume_2     = 0.0f;
     state.enabled      = false;
     state.tIns         = 0.0f;
     state.IE           = 0.0f;
@@ -51,11 +179,19 @@ int main()
         AnalogSensors::instance().applyCalibration(state.cal);
     }
 
-    SensorSampler sampler;
-    sampler.start();
+    // Sample the sensors at 1kHz, averaging blocks of 40 samples: one output
+    // value every sampler update step.
+    AnalogSensors::instance().enableOversampling(1000, 40);
 
+    // UI is refreshed on touch events and on new measurements, at most once
+    // every 50ms.
     BedFsmData UiFsm(state);
     Fsm uiFsm(&UiFsm.mainPage, 50);
+    uiFsm.enableEventMode(50);
+
+    SensorSampler sampler;
+    sampler.setUpdateCallback([&uiFsm]() { uiFsm.notify(); });
+    sampler.start();
     uiFsm.start();
 
     ValveController vc(state);
@@ -64,17 +200,22 @@ int main()
     while(1)
     {
         #ifndef LOG_PRINT
-        if(getchar() == 'd')
+        switch(getchar())
         {
-            loggerSample_t sample;
-            while(state.log.pop(sample))
-            {
-                printf("%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d\n",
-                       sample.timestamp,       sample.pressure,
-                       sample.flow1,           sample.flow2,
-                       sample.volume1,         sample.volume2,
-                      (sample.valves & 0x01), (sample.valves >> 1));
-            }
+            case 'd':
+                dumpBinary();
+                break;
+
+            case 'c':
+                dumpCsv();
+                break;
+
+            case 'j':
+                printJitter(sampler);
+                break;
+
+            default:
+                break;
         }
         #endif
 
@@ -22,7 +22,6 @@
 #include "miosix.h"
 #include "mxgui/display.h"
 
-#include "common/Persistence.h"
 #include "BellJar/LevelController.h"
 #include "BellJar/UI/UiFsmData.h"
 #include "BellJar/BjState.h"
@@ -34,7 +33,7 @@ BjState bjState;
 
 int main()
 {
-    if(loadDataFromFlash(&bjState.ctParams, sizeof(PidParameters)) == false)
+    if(loadBjSettings() == false)
     {
         // Loading saved parameters went wrong, initialize them to safe values
         bjState.ctParams.uMin    = 0.0f;
@@ -51,11 +50,15 @@ int main()
     bjState.zeroLevel  = 0;
     bjState.maxLevel   = 4095;
 
-    LevelController lc;
-    lc.start();
-
+    // UI is refreshed on touch events and at each controller step, at most
+    // once every 50ms.
     BjFsmData bjFsm;
     Fsm uiFsm(&bjFsm.mainPage, 50);
+    uiFsm.enableEventMode(50);
+
+    LevelController lc;
+    lc.setUpdateCallback([&uiFsm]() { uiFsm.notify(); });
+    lc.start();
     uiFsm.start();
 
     unsigned long long time = miosix::getTick();
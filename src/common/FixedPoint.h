@@ -0,0 +1,210 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <limits>
+
+/**
+ * Signed fixed point number in Q format, with F fractional bits stored in a
+ * 32-bit integer. Arithmetic saturates to the representable range instead of
+ * wrapping around; the most negative raw value is left out of the range and
+ * is used as "invalid" marker, the fixed point counterpart of NaN. The marker
+ * is not propagated by the arithmetic operators: it has to be checked where
+ * invalid values can enter the computation, like for float NaNs in the sensor
+ * conversion path.
+ *
+ * @param F: number of fractional bits, from 1 to 31.
+ */
+template< int F >
+class Fixed
+{
+public:
+
+    static_assert((F > 0) && (F < 32), "Invalid number of fractional bits");
+
+    /**
+     * Default constructor, value is zero.
+     */
+    constexpr Fixed() : v(0) { }
+
+    /**
+     * Construct from a floating point value, with rounding to nearest and
+     * saturation. NaN is converted to the invalid marker.
+     *
+     * @param f: value to be converted.
+     */
+    explicit Fixed(const float f) : v(fromFloat(f)) { }
+
+    /**
+     * Construct from a raw Q-format value.
+     *
+     * @param raw: raw value.
+     * @return fixed point number.
+     */
+    static constexpr Fixed fromRaw(const int32_t raw)
+    {
+        return Fixed(raw, 0);
+    }
+
+    /**
+     * @return the invalid marker.
+     */
+    static constexpr Fixed invalid()
+    {
+        return Fixed(INVALID, 0);
+    }
+
+    /**
+     * @return raw Q-format value.
+     */
+    constexpr int32_t raw() const { return v; }
+
+    /**
+     * @return true if the value is not the invalid marker.
+     */
+    constexpr bool isValid() const { return v != INVALID; }
+
+    /**
+     * Convert to floating point, the invalid marker is converted to NaN.
+     */
+    explicit operator float() const
+    {
+        if(v == INVALID) return std::numeric_limits< float >::quiet_NaN();
+        return static_cast< float >(v) * (1.0f / ONE);
+    }
+
+    Fixed operator+(const Fixed& o) const
+    {
+        return Fixed(saturate(static_cast< int64_t >(v) + o.v), 0);
+    }
+
+    Fixed operator-(const Fixed& o) const
+    {
+        return Fixed(saturate(static_cast< int64_t >(v) - o.v), 0);
+    }
+
+    Fixed operator-() const
+    {
+        // INVALID is INT32_MIN, whose negation does not fit in 32 bits
+        if(v == INVALID) return invalid();
+        return Fixed(-v, 0);
+    }
+
+    Fixed operator*(const Fixed& o) const
+    {
+        int64_t p = static_cast< int64_t >(v) * o.v;
+        return Fixed(saturate((p + (INT64_C(1) << (F - 1))) >> F), 0);
+    }
+
+    /**
+     * Division, a division by zero saturates to the largest value with the
+     * sign of the dividend.
+     */
+    Fixed operator/(const Fixed& o) const
+    {
+        if(o.v == 0) return Fixed((v < 0) ? MIN : MAX, 0);
+
+        int64_t n = static_cast< int64_t >(v) * (INT64_C(1) << F);
+        return Fixed(saturate(n / o.v), 0);
+    }
+
+    Fixed& operator+=(const Fixed& o) { return *this = *this + o; }
+    Fixed& operator-=(const Fixed& o) { return *this = *this - o; }
+    Fixed& operator*=(const Fixed& o) { return *this = *this * o; }
+    Fixed& operator/=(const Fixed& o) { return *this = *this / o; }
+
+    constexpr bool operator==(const Fixed& o) const { return v == o.v; }
+    constexpr bool operator!=(const Fixed& o) const { return v != o.v; }
+    constexpr bool operator< (const Fixed& o) const { return v <  o.v; }
+    constexpr bool operator> (const Fixed& o) const { return v >  o.v; }
+    constexpr bool operator<=(const Fixed& o) const { return v <= o.v; }
+    constexpr bool operator>=(const Fixed& o) const { return v >= o.v; }
+
+private:
+
+    static constexpr int32_t INVALID = INT32_MIN;       ///< Invalid marker
+    static constexpr int32_t MIN     = INT32_MIN + 1;   ///< Minimum raw value
+    static constexpr int32_t MAX     = INT32_MAX;       ///< Maximum raw value
+    static constexpr float   ONE     = static_cast< float >(INT64_C(1) << F);
+
+    /**
+     * Construct from a raw value, the dummy argument tells this constructor
+     * apart from the public ones.
+     */
+    constexpr Fixed(const int32_t raw, int) : v(raw) { }
+
+    /**
+     * Saturate a 64-bit intermediate result to the representable range.
+     */
+    static int32_t saturate(const int64_t x)
+    {
+        if(x > MAX) return MAX;
+        if(x < MIN) return MIN;
+        return static_cast< int32_t >(x);
+    }
+
+    /**
+     * Convert a floating point value to raw Q-format.
+     */
+    static int32_t fromFloat(const float f)
+    {
+        if(std::isnan(f)) return INVALID;
+
+        float scaled = std::round(f * ONE);
+        if(scaled >=  2147483647.0f) return MAX;
+        if(scaled <= -2147483647.0f) return MIN;
+        return static_cast< int32_t >(scaled);
+    }
+
+    int32_t v;  ///< Raw value
+};
+
+/**
+ * Check if a value is valid, that is not a NaN.
+ */
+inline bool isValid(const float x)
+{
+    return std::isnan(x) == false;
+}
+
+/**
+ * Check if a value is valid, that is not the invalid marker.
+ */
+template< int F >
+inline bool isValid(const Fixed< F > x)
+{
+    return x.isValid();
+}
+
+/**
+ * Numeric type traits, giving the invalid value of each type.
+ */
+template< typename T >
+struct NumericTraits
+{
+    static T invalid() { return std::numeric_limits< T >::signaling_NaN(); }
+};
+
+template< int F >
+struct NumericTraits< Fixed< F > >
+{
+    static Fixed< F > invalid() { return Fixed< F >::invalid(); }
+};
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <drivers/display_stm32.h>
+#include <mxgui/level2/input.h>
 #include <miosix.h>
 #include <memory>
 #include "ActiveObject.h"
@@ -63,6 +64,10 @@ public:
 /**
  * Active object class which runs a generic FSM, whose states are defined by
  * class FsmState.
+ *
+ * By default the FSM is updated at a fixed rate. In event driven mode the FSM
+ * thread sleeps until a touch event is received or notify() is called, for
+ * example by the threads producing the data shown by the FSM states.
  */
 class Fsm : public ActiveObject
 {
@@ -74,8 +79,15 @@ public:
      * @param timeStep: time step for update rate, in milliseconds.
      */
     Fsm(FsmState *initState, unsigned int timeStep = 0) : curState(initState),
-                                                          delay(timeStep)
+                                                          delay(timeStep),
+                                                          eventMode(false),
+                                                          pending(true),
+                                                          lastUpdate(0)
     {
+        // Draw on a back buffer, so that the screen is updated in background
+        // while the next frame is being drawn. If there is not enough memory
+        // the display falls back to single buffering.
+        DisplayStm32::instance().enableDoubleBuffering();
         curState->enter();
     }
 
@@ -84,6 +96,45 @@ public:
      */
     virtual ~Fsm() { }
 
+    /**
+     * Switch to event driven mode. Must be called before starting the FSM
+     * thread.
+     * @param minPeriod: minimum time between two consecutive updates, in
+     * milliseconds, caps the refresh rate when events come in bursts.
+     */
+    void enableEventMode(unsigned int minPeriod)
+    {
+        delay     = minPeriod;
+        eventMode = true;
+
+        mxgui::InputHandler::instance().registerEventCallback([this]()
+        {
+            notify();
+        });
+    }
+
+    /**
+     * Request an update of the FSM, can be called from any thread. Requests
+     * made while an update is already pending are coalesced with it.
+     * Has no effect if the FSM is not in event driven mode.
+     */
+    void notify()
+    {
+        miosix::Lock< miosix::Mutex > lock(mutex);
+        pending = true;
+        cond.signal();
+    }
+
+    /**
+     * Stop the FSM thread, waking it up if waiting for an event.
+     */
+    virtual void stop() override
+    {
+        should_stop = true;
+        notify();
+        ActiveObject::stop();
+    }
+
 private:
 
     /**
@@ -94,25 +145,56 @@ private:
     {
         while(!should_stop)
         {
+            if(eventMode) waitEvent();
+
             if(curState == nullptr)
             {
                 should_stop = true;
                 break;
             }
 
+            lastUpdate = miosix::getTick();
+
             FsmState *nxtState = curState->update();
-            DisplayStm32::instance().render();
+            DisplayStm32::instance().present();
             if(nxtState != nullptr)
             {
                 curState->leave();
                 curState = nxtState;
                 curState->enter();
+
+                // The new state is updated right away
+                if(eventMode) notify();
             }
 
-            miosix::Thread::sleep(delay);
+            if(eventMode == false) miosix::Thread::sleep(delay);
         }
     }
 
+    /**
+     * Wait until an update is requested. If the request comes earlier than
+     * the minimum period after the last update, the update is postponed and
+     * all the requests made in the meantime are served by it.
+     */
+    void waitEvent()
+    {
+        {
+            miosix::Lock< miosix::Mutex > lock(mutex);
+            while(pending == false) cond.wait(lock);
+        }
+
+        long long next = lastUpdate + delay;
+        if(miosix::getTick() < next) miosix::Thread::sleepUntil(next);
+
+        miosix::Lock< miosix::Mutex > lock(mutex);
+        pending = false;
+    }
+
     FsmState *curState;    ///< Pointer to current FSM state.
     unsigned int delay;    ///< Delay to fix the update rate, in milliseconds.
+    bool eventMode;        ///< Event driven mode enabled.
+    bool pending;          ///< An update has been requested.
+    long long lastUpdate;  ///< Time of the last update, in milliseconds.
+    miosix::Mutex mutex;   ///< Mutex for pending requests.
+    miosix::ConditionVariable cond; ///< Signalled on update requests.
 };
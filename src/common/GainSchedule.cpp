@@ -0,0 +1,84 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "GainSchedule.h"
+
+constexpr size_t  GainSchedule::NUM_POINTS;
+constexpr uint8_t GainSchedule::OFF;
+constexpr uint8_t GainSchedule::LEVEL;
+constexpr uint8_t GainSchedule::SET_POINT;
+
+PidParameters GainSchedule::interpolate(const PidParameters& base,
+                                        const float x) const
+{
+    PidParameters p = base;
+    float pos = std::max(0.0f, std::min(x, 1.0f)) * (NUM_POINTS - 1);
+    int   lo  = -1;
+    int   hi  = -1;
+
+    // Nearest usable points on each side of the scheduling variable, points
+    // without integral action cannot be interpolated in k/Ti and are skipped.
+    for(size_t i = 0; i < NUM_POINTS; i++)
+    {
+        if(((valid & (1 << i)) == 0) || (points[i].Ti <= 0.0f)) continue;
+
+        if(static_cast< float >(i) <= pos) lo = i;
+        if((static_cast< float >(i) >= pos) && (hi < 0)) hi = i;
+    }
+
+    if(lo < 0) lo = hi;
+    if(hi < 0) hi = lo;
+    if(lo < 0) return p;
+
+    // Interpolate the gains of the three terms, k, k/Ti and k*Td, rather than
+    // the times: the integral gain of linearly interpolated k and Ti does not
+    // lie between the ones of the two points.
+    const Point& a = points[lo];
+    const Point& b = points[hi];
+    float t = (hi != lo) ? ((pos - lo) / static_cast< float >(hi - lo)) : 0.0f;
+
+    float ki = a.k/a.Ti + t*(b.k/b.Ti - a.k/a.Ti);
+    float kd = a.k*a.Td + t*(b.k*b.Td - a.k*a.Td);
+
+    p.k  = a.k + t*(b.k - a.k);
+    p.Ti = p.k / ki;
+    p.Td = (p.k > 0.0f) ? (kd / p.k) : 0.0f;
+
+    return p;
+}
+
+void GainSchedule::setPoint(const float x, const PidParameters& p)
+{
+    float  pos = std::max(0.0f, std::min(x, 1.0f)) * (NUM_POINTS - 1);
+    size_t i   = static_cast< size_t >(std::lround(pos));
+
+    points[i].k  = p.k;
+    points[i].Ti = p.Ti;
+    points[i].Td = p.Td;
+    valid       |= (1 << i);
+}
+
+void GainSchedule::clear()
+{
+    for(size_t i = 0; i < NUM_POINTS; i++)
+        points[i] = Point{0.0f, 0.0f, 0.0f};
+
+    valid = 0;
+}
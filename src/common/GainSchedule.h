@@ -0,0 +1,114 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "PidRegulator.h"
+
+/**
+ * Gain scheduling table for a PID regulator.
+ *
+ * The table has NUM_POINTS breakpoints, evenly spaced over the 0.0 - 1.0
+ * range of the scheduling variable, each holding a set of proportional gain,
+ * integral and derivative times. Only the points which have been set take
+ * part in the interpolation: between two of them the proportional, integral
+ * and derivative gains, k, k/Ti and k*Td, change linearly, outside of them
+ * they are held at the value of the nearest one. Points without integral
+ * action are left out.
+ *
+ * The structure is plain data, so that it can be saved as is to the flash
+ * memory. Zero initialisation gives an empty and disabled table.
+ */
+struct GainSchedule
+{
+    static constexpr size_t  NUM_POINTS = 5;    ///< Number of breakpoints
+
+    static constexpr uint8_t OFF        = 0;    ///< Scheduling disabled
+    static constexpr uint8_t LEVEL      = 1;    ///< Scheduling on level
+    static constexpr uint8_t SET_POINT  = 2;    ///< Scheduling on set point
+
+    /**
+     * Tuning parameters of a breakpoint.
+     */
+    struct Point
+    {
+        float k;
+        float Ti;
+        float Td;
+    };
+
+    /**
+     * @param i: breakpoint index.
+     * @return value of the scheduling variable at the breakpoint.
+     */
+    static float breakpoint(const size_t i)
+    {
+        return static_cast< float >(i) / static_cast< float >(NUM_POINTS - 1);
+    }
+
+    /**
+     * @return true if scheduling is enabled and at least one point is set.
+     */
+    bool isActive() const
+    {
+        return (mode != OFF) && (valid != 0);
+    }
+
+    /**
+     * @return true if the table content is consistent, false for corrupted or
+     * uninitialised data.
+     */
+    bool isConsistent() const
+    {
+        return (mode <= SET_POINT) && (valid < (1 << NUM_POINTS));
+    }
+
+    /**
+     * Interpolate the tuning parameters for a given value of the scheduling
+     * variable.
+     *
+     * @param base: regulator parameters, output limits, sample time and
+     * derivative filter are taken from here, as well as the gains if no point
+     * is set.
+     * @param x: scheduling variable, saturated to the 0.0 - 1.0 range.
+     * @return interpolated regulator parameters.
+     */
+    PidParameters interpolate(const PidParameters& base, const float x) const;
+
+    /**
+     * Set the tuning of the breakpoint nearest to a given value of the
+     * scheduling variable.
+     *
+     * @param x: scheduling variable.
+     * @param p: regulator parameters, only gain, integral and derivative times
+     * are used.
+     */
+    void setPoint(const float x, const PidParameters& p);
+
+    /**
+     * Remove all the points from the table, the scheduling mode is left
+     * unchanged.
+     */
+    void clear();
+
+    Point   points[NUM_POINTS];     ///< Breakpoints
+    uint8_t valid;                  ///< Bit mask of the points set
+    uint8_t mode;                   ///< Scheduling variable
+};
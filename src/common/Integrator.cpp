@@ -0,0 +1,73 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include "Integrator.h"
+
+Integrator::Integrator(const float scale, const uint32_t maxGap) : scale(scale),
+maxGap(maxGap), integral(0.0f), prevValue(0.0f), prevTime(0), prevValid(false),
+resetReq(false)
+{
+
+}
+
+Integrator::~Integrator()
+{
+
+}
+
+float Integrator::update(const float value, const uint32_t timestamp)
+{
+    if(resetReq.exchange(false))
+        integral = 0.0f;
+
+    if(std::isnan(value))
+    {
+        prevValid = false;
+        return integral;
+    }
+
+    int32_t dt = static_cast< int32_t >(timestamp - prevTime);
+
+    // Same sample read twice, nothing to do.
+    if(prevValid && (dt == 0) && (value == prevValue))
+        return integral;
+
+    if(prevValid && (dt > 0) && (static_cast< uint32_t >(dt) <= maxGap))
+    {
+        integral += 0.5f * (prevValue + value) * static_cast< float >(dt)
+                  * scale;
+    }
+
+    prevValue = value;
+    prevTime  = timestamp;
+    prevValid = true;
+
+    return integral;
+}
+
+void Integrator::reset()
+{
+    resetReq = false;
+    integral = 0.0f;
+}
+
+void Integrator::requestReset()
+{
+    resetReq = true;
+}
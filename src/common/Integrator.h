@@ -0,0 +1,90 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+/**
+ * Trapezoidal integrator for signals sampled at irregular intervals.
+ *
+ * Each sample comes with its acquisition timestamp and the area between two
+ * consecutive samples is computed using the actual time elapsed between them.
+ * Invalid (NaN) samples, as well as samples spaced more than the maximum gap
+ * time, interrupt the integration: the area over the gap is not accounted and
+ * integration restarts from the next valid sample.
+ */
+class Integrator
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param scale: scale factor applied to the integral of the signal over
+     * time, with time expressed in us.
+     * @param maxGap: maximum time between two samples, in us.
+     */
+    Integrator(const float scale = 1.0f, const uint32_t maxGap = 1000000);
+
+    /**
+     * Destructor.
+     */
+    ~Integrator();
+
+    /**
+     * Add a new sample to the integral.
+     *
+     * @param value: sample value, NaN if not valid.
+     * @param timestamp: acquisition time of the sample, in us. Wrap around of
+     * the timestamp is handled, as long as the time between two samples is
+     * less than 2^31 us.
+     * @return updated value of the integral.
+     */
+    float update(const float value, const uint32_t timestamp);
+
+    /**
+     * @return current value of the integral.
+     */
+    float value() const { return integral; }
+
+    /**
+     * Reset the integral to zero, must be called from the thread feeding the
+     * samples.
+     */
+    void reset();
+
+    /**
+     * Request a reset of the integral, which is carried out when the next
+     * sample is added. The integration restarts from the last sample added,
+     * so that no area is lost. This function can be safely called from any
+     * thread.
+     */
+    void requestReset();
+
+private:
+
+    float               scale;      ///< Output scale factor
+    uint32_t            maxGap;     ///< Maximum gap between samples, in us
+    float               integral;   ///< Current value of the integral
+    float               prevValue;  ///< Value of the previous sample
+    uint32_t            prevTime;   ///< Timestamp of the previous sample
+    bool                prevValid;  ///< Previous sample is valid
+    std::atomic< bool > resetReq;   ///< Reset requested
+};
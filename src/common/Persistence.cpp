@@ -26,21 +26,26 @@ using namespace miosix;
 typedef struct
 {
     uint16_t crc;
-    uint8_t  data[126];
+    uint8_t  data[MAX_DATA_SIZE];
 }
 dataBlock_t;
 
+static const uint8_t  DATA_SECTOR = 11;          // 128kB flash sector
+static const size_t   NUM_BLOCKS  = 1022;        // Data blocks in the sector
+static const uint32_t MEM_MAGIC   = 0x4D424A46;  // "MBJF"
+
 typedef struct
 {
     uint32_t    magic;
     uint32_t    flags[32];
-    dataBlock_t blocks[1024];
+    dataBlock_t blocks[NUM_BLOCKS];
 }
 memory_t;
 
-static const uint32_t MEM_MAGIC   = 0x4D424A46; // "MBJF"
-static const uint32_t baseAddress = 0x080E0000;
-memory_t *memory = ((memory_t *) baseAddress);
+static_assert(sizeof(memory_t) <= 0x20000, "Data exceeds flash sector size");
+
+memory_t *memory = reinterpret_cast< memory_t * >
+                   (flash_sectorAddress(DATA_SECTOR));
 
 
 /**
@@ -57,8 +62,8 @@ static int findActiveBlock()
     if(memory->magic != MEM_MAGIC)
         return -1;
 
-    uint16_t block = 0;
-    uint16_t bit   = 0;
+    int block = 0;
+    int bit   = 0;
 
     // Find the first 32-bit block not full of zeroes
     for(; block < 32; block++)
@@ -102,19 +107,19 @@ bool loadDataFromFlash(void *data, const size_t size)
 
 void saveDataToFlash(void *data, const size_t size)
 {
-    uint32_t addr    = 0;
-    int      block   = findActiveBlock();
-    uint16_t prevCrc = 0;
+    uintptr_t addr    = 0;
+    int       block   = findActiveBlock();
+    uint16_t  prevCrc = 0;
 
     /*
      * Memory never initialised or save space finished: erase all the sector.
-     * On STM32F405 the settings are saved in sector 11, starting at address
-     * 0x08060000.
+     * On STM32F429 the settings are saved in sector 11, starting at address
+     * 0x080E0000.
      */
-    if((block < 0) || (block >= 2047))
+    if((block < 0) || (block >= static_cast< int >(NUM_BLOCKS - 1)))
     {
-        flash_eraseSector(11);
-        addr = reinterpret_cast< uint32_t > (&(memory->magic));
+        flash_eraseSector(DATA_SECTOR);
+        addr = reinterpret_cast< uintptr_t > (&(memory->magic));
         flash_write(addr, &MEM_MAGIC, sizeof(MEM_MAGIC));
         block = 0;
     }
@@ -134,11 +139,11 @@ void saveDataToFlash(void *data, const size_t size)
         return;
 
     // Save data
-    addr = reinterpret_cast< uint32_t > (&(memory->blocks[block]));
+    addr = reinterpret_cast< uintptr_t > (&(memory->blocks[block]));
     flash_write(addr, &tmpBlock, sizeof(dataBlock_t));
 
     // Update the flags marking used data blocks
     uint32_t flag = ~(1 << (block % 32));
-    addr = reinterpret_cast< uint32_t > (&(memory->flags[block / 32]));
+    addr = reinterpret_cast< uintptr_t > (&(memory->flags[block / 32]));
     flash_write(addr, &flag, sizeof(uint32_t));
 }
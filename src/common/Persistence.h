@@ -21,6 +21,11 @@
 #include <cstdint>
 #include <common/PidRegulator.h>
 
+/**
+ * Maximum size of the data saved to the internal flash memory, in bytes.
+ */
+static constexpr size_t MAX_DATA_SIZE = 126;
+
 /**
  * Load data saved into the internal flash memory.
  *
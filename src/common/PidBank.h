@@ -0,0 +1,218 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include "PidRegulator.h"
+
+/**
+ * Bank of N discrete-time PID regulators stepped together, for controllers
+ * serving more than one bed.
+ *
+ * Regulator states and coefficients are stored as a structure of arrays, one
+ * array per variable, and a step updates all the channels in a single loop
+ * without branches, so that the compiler can vectorize it or, on targets
+ * without float SIMD, at least interleave the independent channels in the
+ * FPU pipeline. Each channel follows the same algorithm of PidRegulator and,
+ * given the same inputs, produces the same outputs, tracking mode included.
+ *
+ * @param N: number of channels.
+ */
+template< size_t N >
+class PidBank
+{
+public:
+
+    /**
+     * Constructor, all the channels start with the same parameters.
+     * @param p: regulator parameters
+     */
+    PidBank(const PidParameters& p)
+    {
+        for(size_t i = 0; i < N; i++)
+        {
+            u[i]   = 0.0f;
+            udo[i] = 0.0f;
+            uio[i] = 0.0f;
+            edo[i] = 0.0f;
+            utr[i] = 0.0f;
+            trk[i] = 0;
+            setParameters(i, p);
+        }
+    }
+
+    /**
+     * Destructor
+     */
+    ~PidBank() { }
+
+    /**
+     * Compute one control action for all the channels.
+     *
+     * @param w: regulator set points, one for each channel.
+     * @param y: actual values of the process' outputs, one for each channel.
+     * @param out: buffer for the newly computed control actions, must have room
+     * for N elements. Can be nullptr, the last actions can be read back with
+     * output().
+     */
+    void step(const float * __restrict w, const float * __restrict y,
+              float *out)
+    {
+        for(size_t i = 0; i < N; i++)
+        {
+            float e  = w[i] - y[i];
+            float up = kp[i]*e;
+            float ui = ci[i]*e + uio[i];
+            float ud = cdp[i]*udo[i] + cde[i]*(e-edo[i]);
+            float v  = up + ui + ud;
+
+            // Tracking: output forced, proportional and derivative zeroed.
+            // Selections and saturation are done on values and not through
+            // std::min/max references, which would prevent vectorization.
+            bool  t  = (trk[i] != 0);
+            float tr = utr[i];
+            float lo = uMin[i];
+            float hi = uMax[i];
+
+            v  = t ? tr   : v;
+            up = t ? 0.0f : up;
+            ud = t ? 0.0f : ud;
+            v  = (hi < v) ? hi : v;
+            v  = (lo < v) ? v  : lo;
+
+            uio[i] = v - up - ud;
+            udo[i] = ud;
+            edo[i] = e;
+            u[i]   = v;
+        }
+
+        if(out != nullptr)
+            std::copy(u, u + N, out);
+    }
+
+    /**
+     * @param ch: channel index.
+     * @return last control action computed for a channel.
+     */
+    float output(const size_t ch) const
+    {
+        return u[ch];
+    }
+
+    /**
+     * Get actual tuning parameters of a channel.
+     * @param ch: channel index.
+     * @return a PidParameters object containing the current tuning.
+     */
+    PidParameters getParameters(const size_t ch) const
+    {
+        return pars[ch];
+    }
+
+    /**
+     * Set new tuning parameters for a channel. As in PidRegulator, the change
+     * is bumpless.
+     * @param ch: channel index.
+     * @param p: regulator parameters
+     */
+    void setParameters(const size_t ch, const PidParameters& p)
+    {
+        PidCoefficients c(p);
+
+        pars[ch] = p;
+        kp[ch]   = c.kp;
+        ci[ch]   = c.ci;
+        cdp[ch]  = c.cdp;
+        cde[ch]  = c.cde;
+        uMin[ch] = p.uMin;
+        uMax[ch] = p.uMax;
+
+        if(trk[ch] == 0)
+            uio[ch] = u[ch] - kp[ch]*edo[ch] - udo[ch];
+    }
+
+    /**
+     * Enable tracking mode on a channel, the output keeps the last value
+     * computed before switching.
+     * @param ch: channel index.
+     */
+    void enableTracking(const size_t ch)
+    {
+        utr[ch] = u[ch];
+        trk[ch] = 1;
+    }
+
+    /**
+     * Disable tracking mode on a channel.
+     * @param ch: channel index.
+     */
+    void disableTracking(const size_t ch)
+    {
+        trk[ch] = 0;
+        utr[ch] = 0.0f;
+    }
+
+    /**
+     * Set the output of a channel in tracking mode.
+     * @param ch: channel index.
+     * @param uref: output value.
+     */
+    void setTrackingOutput(const size_t ch, const float uref)
+    {
+        utr[ch] = uref;
+    }
+
+    /**
+     * @param ch: channel index.
+     * @return true if the channel is in tracking mode.
+     */
+    bool isTracking(const size_t ch) const
+    {
+        return trk[ch] != 0;
+    }
+
+    static constexpr size_t CHANNELS = N;   ///< Number of channels
+
+private:
+
+    PidParameters pars[N];  ///< Tuning parameters of each channel
+
+    // Discrete-time coefficients
+    alignas(16) float kp[N];
+    alignas(16) float ci[N];
+    alignas(16) float cdp[N];
+    alignas(16) float cde[N];
+    alignas(16) float uMin[N];
+    alignas(16) float uMax[N];
+
+    // Regulators' internal state
+    alignas(16) float u[N];
+    alignas(16) float uio[N];
+    alignas(16) float edo[N];
+    alignas(16) float udo[N];
+
+    // Tracking
+    alignas(16) float   utr[N];
+    alignas(16) int32_t trk[N];
+};
+
+template< size_t N >
+constexpr size_t PidBank< N >::CHANNELS;
@@ -45,6 +45,21 @@ struct PidParameters
     PidParameters(float k, float Ti, float Td, float N, float uMin, float uMax,
                   float Tsample) : k(k), Ti(Ti), Td(Td), N(N), uMin(uMin),
                   uMax(uMax), Tsample(Tsample) {}
+
+    /**
+     * Compare two sets of parameters.
+     *
+     * @param other: parameters to compare with.
+     * @return true if at least one of the parameters is different.
+     */
+    bool operator!=(const PidParameters& other) const
+    {
+        return (k    != other.k)    || (Ti   != other.Ti)   ||
+               (Td   != other.Td)   || (N    != other.N)    ||
+               (uMin != other.uMin) || (uMax != other.uMax) ||
+               (Tsample != other.Tsample);
+    }
+
     float k;
     float Ti;
     float Td;
@@ -55,10 +70,51 @@ struct PidParameters
 };
 
 
+/**
+ * Coefficients of the discrete-time transfer function of a PID regulator,
+ * obtained from its tuning parameters.
+ */
+struct PidCoefficients
+{
+    /**
+     * Compute the coefficients. An integral time of zero disables the
+     * integral action.
+     *
+     * @param p: regulator parameters.
+     */
+    PidCoefficients(const PidParameters& p) : kp(p.k), ci(0.0f), cdp(0.0f),
+                                              cde(0.0f)
+    {
+        if(p.Ti != 0)
+            ci = p.k*(p.Tsample/p.Ti);
+
+        if((p.Td != 0) && (p.N != 0))
+        {
+            cdp = p.Td/(p.Td+p.N*p.Tsample);
+            cde = (p.k*p.N*p.Td)/(p.Td+p.N*p.Tsample);
+        }
+    }
+
+    float kp;   ///< Proportional gain, k
+    float ci;   ///< Integral gain, k*Tsample/Ti
+    float cdp;  ///< Derivative pole, Td/(Td + N*Tsample)
+    float cde;  ///< Derivative gain, k*N*Td/(Td + N*Tsample)
+};
+
+
 /**
  * Discrete-time PID regulator.
+ *
+ * The coefficients of the discrete-time transfer function are computed once,
+ * when the parameters are set, and not at each step. An integral time of zero
+ * disables the integral action.
+ *
+ * @param T: numeric type used for the computation of the control action,
+ * either float or a fixed point type like Fixed< 24 >. Tuning parameters are
+ * always given as float.
  */
-class PidRegulator
+template< typename T >
+class BasicPidRegulator
 {
 public:
 
@@ -66,12 +122,17 @@ public:
      * Constructor.
      * @param p: regulator parameters
      */
-    PidRegulator(const PidParameters& p);
+    BasicPidRegulator(const PidParameters& p) : pars(p), u(0.0f), up(0.0f),
+    ud(0.0f), ui(0.0f), uio(0.0f), edo(0.0f), udo(0.0f),trackingEnabled(false),
+    utr(0.0f)
+    {
+        updateCoefficients();
+    }
 
     /**
      * Destructor
      */
-    ~PidRegulator();
+    ~BasicPidRegulator() { }
 
     /**
      * Compute one control action, i.e. perform one step of a periodic
@@ -81,52 +142,145 @@ public:
      * with respect to the reference is done internally.
      * @return newly computed control action u
      */
-    float computeAction(const float w, const float y);
+    T computeAction(const T w, const T y)
+    {
+        // Run mode: at each step a new value for up, ui and ud is computed.
+        // Hold mode: up, ui and ud are not updated and keep their previous
+        // value, the only thing to do is to update ud(k-1) and ui(k-1).
+
+        // Current error
+        T e = w - y;
+
+        // Proportional
+        up = kp*e;
+
+        // Integrative
+        ui = ci*e + uio;
+
+        // Derivative
+        ud = cdp*udo + cde*(e-edo);
+
+        if(trackingEnabled)
+        {
+            u  = utr;
+            ud = T(0.0f);
+            up = T(0.0f);
+        }
+        else
+        {
+            u = up + ui + ud;
+        }
+
+        u = std::max(uMin, std::min(u, uMax));
+        uio = u - up - ud;
+        udo = ud;
+        edo = e;
+
+        return u;
+    }
 
     /**
      * Get actual regulator's tuning parameters.
      * @return a PidParameters object containing the current tuning.
      */
-    PidParameters getParameters() const;
+    PidParameters getParameters() const
+    {
+        return pars;
+    }
 
     /**
-     * Set new regulator's tuning parameters.
+     * Set new regulator's tuning parameters. The change is bumpless: the
+     * integral state is adjusted so that, with the same error, the output
+     * keeps the last value computed before the change.
      * @param p: regulator parameters
      */
-    void setParameters(const PidParameters& p);
+    void setParameters(const PidParameters& p)
+    {
+        pars = p;
+        updateCoefficients();
+
+        // Bumpless retune: with the last error, the new proportional action
+        // plus the integral and derivative ones give back the last output.
+        if(trackingEnabled == false)
+        {
+            up  = kp*edo;
+            uio = u - up - udo;
+        }
+    }
 
     /**
      * Enable tracking mode.
      * To avoid bumps, when tracking is enabled the regulator output keeps the
      * last value computed before switching.
      */
-    void enableTracking();
+    void enableTracking()
+    {
+        utr = u;
+        trackingEnabled = true;
+    }
 
     /**
      * Disable tracking mode.
      */
-    void disableTracking();
+    void disableTracking()
+    {
+        trackingEnabled = false;
+        utr = T(0.0f);
+    }
 
     /**
      * Set a value for the output whe regulator is in tracking mode.
      */
-    void setTrackingOutput(float uref);
+    void setTrackingOutput(T uref)
+    {
+        utr = uref;
+    }
 
 private:
 
+    /**
+     * Compute the discrete-time coefficients from the current parameters.
+     */
+    void updateCoefficients()
+    {
+        PidCoefficients c(pars);
+
+        kp   = T(c.kp);
+        ci   = T(c.ci);
+        cdp  = T(c.cdp);
+        cde  = T(c.cde);
+        uMin = T(pars.uMin);
+        uMax = T(pars.uMax);
+    }
+
     // regulator's parameters
     PidParameters pars;
 
+    // Discrete-time coefficients
+    T kp;       ///< Proportional gain, k
+    T ci;       ///< Integral gain, k*Tsample/Ti
+    T cdp;      ///< Derivative pole, Td/(Td + N*Tsample)
+    T cde;      ///< Derivative gain, k*N*Td/(Td + N*Tsample)
+    T uMin;     ///< Output lower limit
+    T uMax;     ///< Output upper limit
+
     // Controller internal state
-    float u;
-    float up;
-    float ud;
-    float ui;
-    float uio;
-    float edo;
-    float udo;
+    T u;
+    T up;
+    T ud;
+    T ui;
+    T uio;
+    T edo;
+    T udo;
 
     // Tracking
     bool trackingEnabled;
-    float utr;
+    T utr;
 };
+
+extern template class BasicPidRegulator< float >;
+
+/**
+ * Floating point PID regulator.
+ */
+typedef BasicPidRegulator< float > PidRegulator;
@@ -0,0 +1,158 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "RelayAutotuner.h"
+
+constexpr uint8_t  RelayAutotuner::SKIP_CYCLES;
+constexpr uint8_t  RelayAutotuner::NUM_CYCLES;
+constexpr uint32_t RelayAutotuner::MAX_TIME;
+
+RelayAutotuner::RelayAutotuner() : state(Status::IDLE), bias(0.0f), d(0.0f),
+                                   eps(0.0f), Ts(0.0f), high(false), steps(0),
+                                   maxSteps(0), lastRise(0), cycles(0),
+                                   yMax(0.0f), yMin(0.0f), sumAmpl(0.0f),
+                                   sumPeriod(0.0f), Ku(0.0f), Tu(0.0f)
+{
+
+}
+
+RelayAutotuner::~RelayAutotuner()
+{
+
+}
+
+void RelayAutotuner::start(const float bias, const float amplitude,
+                           const float hysteresis, const float Tsample,
+                           const float uMin, const float uMax)
+{
+    this->bias = bias;
+    d          = std::min(amplitude, std::min(uMax - bias, bias - uMin));
+    eps        = hysteresis;
+    Ts         = Tsample;
+    high       = false;
+    steps      = 0;
+    lastRise   = 0;
+    cycles     = 0;
+    sumAmpl    = 0.0f;
+    sumPeriod  = 0.0f;
+    yMax       = -INFINITY;
+    yMin       = INFINITY;
+
+    // No room to move the process input or no time base, give up
+    if((d <= 0.0f) || (Ts <= 0.0f))
+    {
+        state = Status::FAILED;
+        return;
+    }
+
+    maxSteps = static_cast< uint32_t >(MAX_TIME / Ts);
+    state    = Status::RUNNING;
+}
+
+float RelayAutotuner::step(const float w, const float y)
+{
+    if(state != Status::RUNNING)
+        return bias;
+
+    float e   = w - y;
+    bool  was = high;
+
+    if(e > eps)  high = true;
+    if(e < -eps) high = false;
+
+    yMax   = std::max(yMax, y);
+    yMin   = std::min(yMin, y);
+    steps += 1;
+
+    // A cycle ends at each low to high switch. The first switch only marks
+    // the start of the first cycle.
+    if((high == true) && (was == false))
+    {
+        if(lastRise != 0)
+        {
+            cycles += 1;
+
+            if(cycles > SKIP_CYCLES)
+            {
+                sumAmpl   += (yMax - yMin) / 2.0f;
+                sumPeriod += static_cast< float >(steps - lastRise);
+            }
+        }
+
+        lastRise = steps;
+        yMax     = y;
+        yMin     = y;
+
+        if(cycles >= SKIP_CYCLES + NUM_CYCLES)
+        {
+            finish();
+            return bias;
+        }
+    }
+
+    if(steps >= maxSteps)
+    {
+        state = Status::FAILED;
+        return bias;
+    }
+
+    return high ? (bias + d) : (bias - d);
+}
+
+void RelayAutotuner::abort()
+{
+    if(state == Status::RUNNING)
+        state = Status::IDLE;
+}
+
+PidParameters RelayAutotuner::proposal(const PidParameters& base) const
+{
+    PidParameters p = base;
+
+    // Ziegler-Nichols gain. The Ziegler-Nichols times aim at a quarter decay
+    // ratio, which overshoots the bell jar level set point steps by up to 12%.
+    p.k  = 0.6f * Ku;
+    p.Ti = 0.6f * Tu;
+    p.Td = 0.08f * Tu;
+
+    // Derivative action needs its filter
+    if(p.N == 0.0f)
+        p.N = 10.0f;
+
+    return p;
+}
+
+void RelayAutotuner::finish()
+{
+    float a = sumAmpl / NUM_CYCLES;
+
+    // The limit cycle must be wider than the hysteresis band, otherwise the
+    // oscillation is driven by noise and not by the process dynamics.
+    if(a <= eps)
+    {
+        state = Status::FAILED;
+        return;
+    }
+
+    constexpr float PI = 3.14159265f;
+    Ku    = (4.0f * d) / (PI * std::sqrt(a*a - eps*eps));
+    Tu    = (sumPeriod / NUM_CYCLES) * Ts;
+    state = Status::DONE;
+}
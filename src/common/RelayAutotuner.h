@@ -0,0 +1,142 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include "PidRegulator.h"
+
+/**
+ * Relay feedback autotuner, after Astrom and Hagglund.
+ *
+ * During the experiment the process input is driven by a relay with
+ * hysteresis, switching between bias + d and bias - d according to the sign
+ * of the control error. The loop settles into a limit cycle whose period is
+ * the ultimate period Tu of the process and whose amplitude a gives the
+ * ultimate gain, Ku = 4d/(pi*sqrt(a^2 - eps^2)), eps being the hysteresis.
+ * A PID tuning is then proposed from the Ziegler-Nichols rules, with longer
+ * integral and shorter derivative times to limit the set point overshoot.
+ */
+class RelayAutotuner
+{
+public:
+
+    /**
+     * Experiment status.
+     */
+    enum class Status : uint8_t
+    {
+        IDLE    = 0,    ///< No experiment started or experiment aborted
+        RUNNING = 1,    ///< Experiment in progress
+        DONE    = 2,    ///< Experiment completed, results available
+        FAILED  = 3     ///< No stable limit cycle found
+    };
+
+    /**
+     * Constructor.
+     */
+    RelayAutotuner();
+
+    /**
+     * Destructor.
+     */
+    ~RelayAutotuner();
+
+    /**
+     * Start a new experiment. The relay amplitude is reduced, if needed, to
+     * keep the process input within the given limits.
+     *
+     * @param bias: process input around which the relay switches, should keep
+     * the process output close to the set point.
+     * @param amplitude: relay amplitude d.
+     * @param hysteresis: relay hysteresis, in process output units.
+     * @param Tsample: period of the calls to step(), in s.
+     * @param uMin: minimum allowed process input.
+     * @param uMax: maximum allowed process input.
+     */
+    void start(const float bias, const float amplitude, const float hysteresis,
+               const float Tsample, const float uMin, const float uMax);
+
+    /**
+     * Perform one step of the experiment.
+     *
+     * @param w: set point.
+     * @param y: actual value of the process output.
+     * @return process input to be applied, the bias value once the experiment
+     * is over.
+     */
+    float step(const float w, const float y);
+
+    /**
+     * Stop a running experiment, the status goes back to idle.
+     */
+    void abort();
+
+    /**
+     * @return current status of the experiment.
+     */
+    Status status() const { return state; }
+
+    /**
+     * @return ultimate gain identified by the last successful experiment.
+     */
+    float ultimateGain() const { return Ku; }
+
+    /**
+     * @return ultimate period identified by the last successful experiment,
+     * in s.
+     */
+    float ultimatePeriod() const { return Tu; }
+
+    /**
+     * Compute the tuning proposed from the last successful experiment.
+     *
+     * @param base: current regulator parameters, output limits, sample time and
+     * derivative filter are taken from here.
+     * @return proposed regulator parameters.
+     */
+    PidParameters proposal(const PidParameters& base) const;
+
+    static constexpr uint8_t  SKIP_CYCLES = 2;     ///< Initial transient cycles
+    static constexpr uint8_t  NUM_CYCLES  = 4;     ///< Averaged cycles
+    static constexpr uint32_t MAX_TIME    = 600;   ///< Experiment timeout, in s
+
+private:
+
+    /**
+     * Close the experiment and compute its results.
+     */
+    void finish();
+
+    volatile Status state;  ///< Experiment status
+    float    bias;          ///< Relay bias
+    float    d;             ///< Relay amplitude
+    float    eps;           ///< Relay hysteresis
+    float    Ts;            ///< Sample time, in s
+    bool     high;          ///< Relay output is high
+    uint32_t steps;         ///< Steps since the experiment start
+    uint32_t maxSteps;      ///< Steps before timeout
+    uint32_t lastRise;      ///< Step of the last low to high switch
+    uint8_t  cycles;        ///< Completed cycles
+    float    yMax;          ///< Maximum output in the current cycle
+    float    yMin;          ///< Minimum output in the current cycle
+    float    sumAmpl;       ///< Sum of the peak to peak output amplitudes
+    float    sumPeriod;     ///< Sum of the cycle periods, in steps
+    float    Ku;            ///< Ultimate gain
+    float    Tu;            ///< Ultimate period, in s
+};
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <miosix.h>
+#include <algorithm>
 #include <cstdint>
 
 /**
@@ -30,10 +31,20 @@ class RingBuffer
 {
 public:
 
+    /**
+     * Contiguous block of elements stored inside the buffer.
+     */
+    struct Span
+    {
+        const T *data;  ///< Pointer to the first element of the block.
+        size_t  len;    ///< Number of elements in the block.
+    };
+
     /**
      * Constructor.
      */
-    RingBuffer() : readPos(0), writePos(0), numElements(0)
+    RingBuffer() : readPos(0), writePos(0), numElements(0), numDropped(0),
+                   spanDropped(0)
     {
         data = new T[N];
     }
@@ -63,7 +74,7 @@ public:
         {
             if(erase)
             {
-                eraseElement();
+                dropElement();
             }
             else
             {
@@ -99,6 +110,60 @@ public:
         return true;
     }
 
+    /**
+     * Get direct access to the oldest elements in the buffer without removing
+     * them. Since the elements may wrap around the end of the storage array,
+     * they are returned as two contiguous blocks: the second one is empty if
+     * no wrap-around occurs. Elements have to be removed afterwards by calling
+     * commitRead().
+     *
+     * @param first: first block of elements, the oldest ones.
+     * @param second: second block of elements, following the first one.
+     * @param maxCount: maximum number of elements to be returned.
+     * @return total number of elements in the two blocks.
+     */
+    size_t readSpans(Span& first, Span& second, const size_t maxCount = N)
+    {
+        miosix::Lock< miosix::Mutex > l(mutex);
+
+        size_t count = std::min(numElements, maxCount);
+
+        first.data  = &data[readPos];
+        first.len   = std::min(count, N - readPos);
+        second.data = &data[0];
+        second.len  = count - first.len;
+        spanDropped = numDropped;
+
+        return count;
+    }
+
+    /**
+     * Remove from the buffer elements previously obtained through readSpans().
+     *
+     * If in the meantime some elements have been erased to make room for new
+     * ones, the content of the blocks returned by readSpans() may have been
+     * overwritten while being read and the function returns false.
+     *
+     * @param n: number of elements to remove, starting from the oldest one.
+     * @return true if none of the elements has been overwritten, false
+     * otherwise.
+     */
+    bool commitRead(const size_t n)
+    {
+        miosix::Lock< miosix::Mutex > l(mutex);
+
+        // Elements erased after readSpans() were already removed
+        size_t erased = numDropped - spanDropped;
+        if(erased < n)
+        {
+            size_t count = std::min(n - erased, numElements);
+            readPos      = (readPos + count) % N;
+            numElements -= count;
+        }
+
+        return erased == 0;
+    }
+
     /**
      * Check if the buffer is empty.
      *
@@ -127,20 +192,31 @@ public:
     void eraseElement()
     {
         miosix::Lock< miosix::Mutex > l(mutex);
+        dropElement();
+    }
+
+private:
 
+    /**
+     * Discard one element from the buffer's tail, to be called with the mutex
+     * already locked.
+     */
+    void dropElement()
+    {
         // Nothing to erase
         if(numElements == 0) return;
 
         // Chomp away one element just by advancing the read pointer.
         readPos = (readPos + 1) % N;
         numElements -= 1;
+        numDropped  += 1;
     }
 
-private:
-
     size_t readPos;      ///< Read pointer.
     size_t writePos;     ///< Write pointer.
     size_t numElements;  ///< Number of elements currently present.
+    size_t numDropped;   ///< Number of elements erased so far.
+    size_t spanDropped;  ///< Value of numDropped at readSpans().
     T      *data;        ///< Data storage.
 
     miosix::Mutex mutex; ///< Mutex for concurrent access.
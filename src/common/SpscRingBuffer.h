@@ -0,0 +1,262 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+
+/**
+ * Class implementing a dinamically allocated, lock-free circular buffer for
+ * the case of a single producer thread and a single consumer thread.
+ *
+ * Read and write positions are free-running counters, the index inside the
+ * storage array is obtained by masking them: for this reason the buffer size
+ * has to be a power of two.
+ *
+ * In overwrite mode the producer discards the oldest element by advancing the
+ * read position through a compare-and-swap. The consumer detects this case by
+ * a failure of its own compare-and-swap and retries with the next element, so
+ * it never returns an element which has been overwritten while being copied.
+ */
+template < typename T, size_t N >
+class SpscRingBuffer
+{
+    static_assert((N != 0) && ((N & (N - 1)) == 0),
+                  "SpscRingBuffer size must be a power of two");
+
+public:
+
+    /**
+     * Contiguous block of elements stored inside the buffer.
+     */
+    struct Span
+    {
+        const T *data;  ///< Pointer to the first element of the block.
+        size_t  len;    ///< Number of elements in the block.
+    };
+
+    /**
+     * Constructor.
+     */
+    SpscRingBuffer() : readPos(0), writePos(0), numDropped(0), spanStart(0)
+    {
+        data = new T[N];
+    }
+
+    /**
+     * Destructor.
+     */
+    ~SpscRingBuffer()
+    {
+        delete[] data;
+    }
+
+    /**
+     * Push an element to the buffer. This function must be called only by
+     * the producer thread.
+     *
+     * @param elem: element to be pushed.
+     * @param erase: if set to true, when the buffer is full this function
+     * erases the oldest element in the buffer to make room for the new one.
+     * @return true if the element has been successfully pushed to the queue,
+     * false if the queue is full.
+     */
+    bool push(const T& elem, bool erase)
+    {
+        size_t wr = writePos.load(std::memory_order_relaxed);
+        size_t rd = readPos.load(std::memory_order_acquire);
+
+        if((wr - rd) >= N)
+        {
+            if(erase == false)
+                return false;
+
+            // Drop the oldest element. If the exchange fails the consumer
+            // just popped it, either way there is now a free slot.
+            if(readPos.compare_exchange_strong(rd, rd + 1,
+                                               std::memory_order_acq_rel))
+            {
+                numDropped.store(numDropped.load(std::memory_order_relaxed) + 1,
+                                 std::memory_order_relaxed);
+            }
+        }
+
+        data[wr & MASK] = elem;
+        writePos.store(wr + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Pop an element from the buffer. This function must be called only by
+     * the consumer thread.
+     *
+     * @param elem: place where to store the popped element.
+     * @return true if the element has been successfully popped from the queue,
+     * false if the queue is empty.
+     */
+    bool pop(T& elem)
+    {
+        size_t rd = readPos.load(std::memory_order_acquire);
+
+        while(true)
+        {
+            size_t wr = writePos.load(std::memory_order_acquire);
+            if(rd == wr)
+                return false;
+
+            elem = data[rd & MASK];
+
+            // On failure rd is reloaded with the actual read position, the
+            // element just copied may have been overwritten by the producer.
+            if(readPos.compare_exchange_weak(rd, rd + 1,
+                                             std::memory_order_acq_rel))
+                return true;
+        }
+    }
+
+    /**
+     * Get direct access to the oldest elements in the buffer without removing
+     * them. Since the elements may wrap around the end of the storage array,
+     * they are returned as two contiguous blocks: the second one is empty if
+     * no wrap-around occurs. Elements have to be removed afterwards by calling
+     * commitRead(). This function must be called only by the consumer thread.
+     *
+     * @param first: first block of elements, the oldest ones.
+     * @param second: second block of elements, following the first one.
+     * @param maxCount: maximum number of elements to be returned.
+     * @return total number of elements in the two blocks.
+     */
+    size_t readSpans(Span& first, Span& second, const size_t maxCount = N)
+    {
+        size_t rd    = readPos.load(std::memory_order_acquire);
+        size_t wr    = writePos.load(std::memory_order_acquire);
+        size_t count = std::min(wr - rd, maxCount);
+        size_t start = rd & MASK;
+
+        first.data  = &data[start];
+        first.len   = std::min(count, N - start);
+        second.data = &data[0];
+        second.len  = count - first.len;
+        spanStart   = rd;
+
+        return count;
+    }
+
+    /**
+     * Remove from the buffer elements previously obtained through readSpans().
+     * This function must be called only by the consumer thread.
+     *
+     * When the buffer is in overwrite mode the producer may have discarded
+     * some of the elements in the meantime, in this case the content of the
+     * blocks returned by readSpans() may have been overwritten while being
+     * read and the function returns false.
+     *
+     * @param n: number of elements to remove, starting from the oldest one.
+     * @return true if none of the elements has been overwritten by the
+     * producer, false otherwise.
+     */
+    bool commitRead(const size_t n)
+    {
+        size_t rd     = spanStart;
+        size_t target = spanStart + n;
+
+        if(readPos.compare_exchange_strong(rd, target,
+                                           std::memory_order_acq_rel))
+            return true;
+
+        // Producer discarded some elements, advance the read position only if
+        // it did not already move past the committed ones.
+        while((rd - spanStart) < n)
+        {
+            if(readPos.compare_exchange_strong(rd, target,
+                                               std::memory_order_acq_rel))
+                break;
+        }
+
+        return false;
+    }
+
+    /**
+     * Check if the buffer is empty.
+     *
+     * @return true if the buffer is empty.
+     */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * Check if the buffer is full.
+     *
+     * @return true if the buffer is full.
+     */
+    bool full() const
+    {
+        return size() >= N;
+    }
+
+    /**
+     * Get the number of elements currently present in the buffer.
+     *
+     * @return number of elements present in the buffer.
+     */
+    size_t size() const
+    {
+        size_t rd = readPos.load(std::memory_order_acquire);
+        size_t wr = writePos.load(std::memory_order_acquire);
+
+        return wr - rd;
+    }
+
+    /**
+     * Get the number of elements discarded by the producer in overwrite mode.
+     * Elements discarded by the consumer, after a failed commitRead(), are not
+     * counted.
+     *
+     * @return number of elements discarded so far.
+     */
+    size_t dropped() const
+    {
+        return numDropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the buffer capacity.
+     *
+     * @return maximum number of elements the buffer can hold.
+     */
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+private:
+
+    static constexpr size_t MASK = N - 1;   ///< Index mask.
+
+    std::atomic< size_t > readPos;          ///< Read counter.
+    std::atomic< size_t > writePos;         ///< Write counter.
+    std::atomic< size_t > numDropped;       ///< Elements dropped by push().
+    size_t                spanStart;        ///< Read counter at readSpans().
+    T                     *data;            ///< Data storage.
+};
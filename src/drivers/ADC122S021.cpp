@@ -16,7 +16,6 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <limits>
 #include <miosix.h>
 #include "hwmapping.h"
 #include "ADC122S021.h"
@@ -42,13 +41,82 @@ public:
     }
 };
 
-ADC122S021& ADC122S021::instance()
+/*
+ * SPI4 DMA mapping: RX on DMA2 stream 0, TX on DMA2 stream 1, both on
+ * channel 4.
+ */
+static constexpr uint32_t RX_STREAM_FLAGS = DMA_LIFCR_CTCIF0
+                                          | DMA_LIFCR_CHTIF0
+                                          | DMA_LIFCR_CTEIF0
+                                          | DMA_LIFCR_CDMEIF0
+                                          | DMA_LIFCR_CFEIF0;
+
+static constexpr uint32_t TX_STREAM_FLAGS = DMA_LIFCR_CTCIF1
+                                          | DMA_LIFCR_CHTIF1
+                                          | DMA_LIFCR_CTEIF1
+                                          | DMA_LIFCR_CDMEIF1
+                                          | DMA_LIFCR_CFEIF1;
+
+static Thread * volatile waiting = nullptr;  // Thread waiting for DMA
+static volatile bool     dmaError = false;   // DMA transfer error
+
+/**
+ * \internal
+ * Actual implementation of the DMA interrupt handler, shared between the RX and
+ * TX streams. Wakes up the waiting thread when the RX stream has received all
+ * the words or when one of the two streams reports a transfer error.
+ */
+void __attribute__((used)) adcDmaIrqImpl()
+{
+    uint32_t flags = DMA2->LISR;
+    DMA2->LIFCR    = flags & (RX_STREAM_FLAGS | TX_STREAM_FLAGS);
+
+    if((flags & (DMA_LISR_TEIF0 | DMA_LISR_TEIF1)) != 0)
+    {
+        DMA2_Stream0->CR = 0;
+        DMA2_Stream1->CR = 0;
+        dmaError = true;
+    }
+    else if((flags & DMA_LISR_TCIF0) == 0)
+    {
+        return;
+    }
+
+    if(waiting == nullptr) return;
+
+    waiting->IRQwakeup();
+    if(waiting->IRQgetPriority() >
+       Thread::IRQgetCurrentThread()->IRQgetPriority())
+    {
+        Scheduler::IRQfindNextThread();
+    }
+
+    waiting = nullptr;
+}
+
+/**
+ * DMA2 stream 0 interrupt handler, SPI4 RX.
+ */
+void __attribute__((naked)) DMA2_Stream0_IRQHandler()
 {
-    static ADC122S021 adc;
-    return adc;
+    saveContext();
+    asm volatile("bl _Z13adcDmaIrqImplv");
+    restoreContext();
 }
 
-ADC122S021::ADC122S021()
+/**
+ * DMA2 stream 1 interrupt handler, SPI4 TX.
+ */
+void __attribute__((naked)) DMA2_Stream1_IRQHandler()
+{
+    saveContext();
+    asm volatile("bl _Z13adcDmaIrqImplv");
+    restoreContext();
+}
+
+
+
+ADC122S021::ADC122S021() : mode(AdcTransfer::DMA)
 {
     adc::cs::mode(Mode::OUTPUT);
     adc::cs::high();
@@ -62,6 +130,7 @@ ADC122S021::ADC122S021()
     adc::sck::alternateFunction(5);
 
     RCC->APB2ENR |= RCC_APB2ENR_SPI4EN;
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
     RCC_SYNC();
 
     SPI4->CR1 = SPI_CR1_DFF     // 16-bit transfer size
@@ -71,71 +140,144 @@ ADC122S021::ADC122S021()
               | SPI_CR1_BR_0
               | SPI_CR1_MSTR;   // Master mode
 
+    SPI4->CR2 = SPI_CR2_RXDMAEN
+              | SPI_CR2_TXDMAEN;
+
     SPI4->CR1 |= SPI_CR1_SPE;   // Enable peripheral
 
+    // Both streams move 16-bit words from/to the SPI data register.
+    DMA2_Stream0->CR  = 0;
+    DMA2_Stream0->PAR = reinterpret_cast< uint32_t >(&SPI4->DR);
+    DMA2_Stream1->CR  = 0;
+    DMA2_Stream1->PAR = reinterpret_cast< uint32_t >(&SPI4->DR);
+
+    NVIC_ClearPendingIRQ(DMA2_Stream0_IRQn);
+    NVIC_SetPriority(DMA2_Stream0_IRQn, 10);
+    NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+    NVIC_ClearPendingIRQ(DMA2_Stream1_IRQn);
+    NVIC_SetPriority(DMA2_Stream1_IRQn, 10);
+    NVIC_EnableIRQ(DMA2_Stream1_IRQn);
+
     // Default values for conversion offset and slope
     CH_OFFSET[0] = 0.0f;
     CH_OFFSET[1] = 0.0f;
-    CH_SLOPE[0]  = 4096.0f/5.0f;
-    CH_SLOPE[1]  = 4096.0f/5.0f;
+    CH_GAIN[0]   = 5.0f/4096.0f;
+    CH_GAIN[1]   = 5.0f/4096.0f;
 }
 
 ADC122S021::~ADC122S021()
 {
+    NVIC_DisableIRQ(DMA2_Stream0_IRQn);
+    NVIC_DisableIRQ(DMA2_Stream1_IRQn);
+    DMA2_Stream0->CR = 0;
+    DMA2_Stream1->CR = 0;
+
     adc::cs::high();
     RCC->APB2ENR &= ~RCC_APB2ENR_SPI4EN;
 }
 
-uint16_t ADC122S021::getRawValue(const AdcChannel channel)
+bool ADC122S021::transferPolled(const uint16_t *tx, uint16_t *rx,
+                                const uint16_t count)
 {
-    // Select the ADC
-    ScopedCs cs;
-    delayUs(1);
-
-    uint16_t ch = static_cast< uint16_t >(channel) << 11;
-    long long t = getTick();
+    // Flush data register and reset RXNE flag.
+    (void) SPI4->DR;
 
-    // Set the channel to be sampled, incoming value is discarded.
-    SPI4->DR = ch;
-    while((SPI4->SR & SPI_SR_RXNE) == 0)
+    for(uint16_t i = 0; i < count; i++)
     {
-        if((getTick() - t) > 10)
+        long long t = getTick();
+
+        SPI4->DR = tx[i];
+        while((SPI4->SR & SPI_SR_RXNE) == 0)
         {
-            return 0xFFFF;
+            if((getTick() - t) > TIMEOUT)
+            {
+                return false;
+            }
         }
+
+        rx[i] = SPI4->DR;
     }
 
+    return true;
+}
+
+bool ADC122S021::transferDma(const uint16_t *tx, uint16_t *rx,
+                             const uint16_t count)
+{
     // Flush data register and reset RXNE flag.
     (void) SPI4->DR;
-    SPI4->SR &= ~SPI_SR_RXNE;
 
-    // Get a sample of the channel voltage.
-    t = getTick();
-    SPI4->DR = ch;
-    while((SPI4->SR & SPI_SR_RXNE) == 0)
+    DMA2->LIFCR = RX_STREAM_FLAGS | TX_STREAM_FLAGS;
+
+    DMA2_Stream0->M0AR = reinterpret_cast< uint32_t >(rx);
+    DMA2_Stream0->NDTR = count;
+    DMA2_Stream1->M0AR = reinterpret_cast< uint32_t >(tx);
+    DMA2_Stream1->NDTR = count;
+
+    dmaError = false;
+    waiting  = Thread::getCurrentThread();
+
+    // Enable the RX stream first, so that no incoming word is lost.
+    DMA2_Stream0->CR = DMA_SxCR_CHSEL_2     // Channel 4
+                     | DMA_SxCR_PL_1        // High priority
+                     | DMA_SxCR_MSIZE_0     // 16-bit memory access
+                     | DMA_SxCR_PSIZE_0     // 16-bit peripheral access
+                     | DMA_SxCR_MINC        // Increment memory address
+                     | DMA_SxCR_TCIE        // Interrupt on completion
+                     | DMA_SxCR_TEIE        // Interrupt on error
+                     | DMA_SxCR_EN;
+
+    DMA2_Stream1->CR = DMA_SxCR_CHSEL_2     // Channel 4
+                     | DMA_SxCR_PL_1        // High priority
+                     | DMA_SxCR_MSIZE_0     // 16-bit memory access
+                     | DMA_SxCR_PSIZE_0     // 16-bit peripheral access
+                     | DMA_SxCR_MINC        // Increment memory address
+                     | DMA_SxCR_DIR_0       // Memory to peripheral
+                     | DMA_SxCR_TEIE        // Interrupt on error
+                     | DMA_SxCR_EN;
+
+    // Sleep until the interrupt handler signals the end of the transfer. The
+    // elapsed time is checked at every wakeup: on timeout both streams are
+    // stopped before clearing the waiting thread, so that a late interrupt
+    // finds nothing to wake up.
+    bool timeout = false;
     {
-        if((getTick() - t) > 10)
+        FastInterruptDisableLock dLock;
+        long long t = getTick();
+        while(waiting != nullptr)
         {
-            return 0xFFFF;
+            if((getTick() - t) > TIMEOUT)
+            {
+                DMA2_Stream0->CR = 0;
+                DMA2_Stream1->CR = 0;
+                waiting = nullptr;
+                timeout = true;
+                break;
+            }
+
+            Thread::IRQwait();
+            {
+                FastInterruptEnableLock eLock(dLock);
+                Thread::yield();
+            }
         }
     }
 
-    return SPI4->DR;
+    DMA2_Stream0->CR = 0;
+    DMA2_Stream1->CR = 0;
+
+    return (dmaError == false) && (timeout == false);
 }
 
-float ADC122S021::getVoltage(const AdcChannel channel)
+bool ADC122S021::transfer(const uint16_t *tx, uint16_t *rx,
+                          const uint16_t count)
 {
-    float value = static_cast< float >(getRawValue(channel));
-    uint16_t ch = static_cast< uint16_t >(channel);
+    // Select the ADC
+    ScopedCs cs;
+    delayUs(1);
 
-    if(value < CH_OFFSET[ch]) return 0.0f;
-    return (value - CH_OFFSET[ch]) / CH_SLOPE[ch];
-}
+    if(mode == AdcTransfer::DMA)
+        return transferDma(tx, rx, count);
 
-void ADC122S021::setConversionParameters(const AdcChannel channel,
-                                         const float slope, const float offset)
-{
-    uint16_t ch   = static_cast< uint16_t >(channel);
-    CH_SLOPE[ch]  = slope;
-    CH_OFFSET[ch] = offset;
+    return transferPolled(tx, rx, count);
 }
@@ -19,6 +19,8 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
+#include "common/FixedPoint.h"
 
 /**
  * Enumeration type for safe ADC channel selection.
@@ -29,6 +31,15 @@ enum class AdcChannel : uint8_t
     _2 = 1
 };
 
+/**
+ * Enumeration type for ADC transfer mode selection.
+ */
+enum class AdcTransfer : uint8_t
+{
+    POLLED = 0,     ///< CPU polls the SPI status register.
+    DMA    = 1      ///< DMA transfer, calling thread sleeps until completion.
+};
+
 /**
  * Driver for ADC122S021 ADC IC.
  */
@@ -67,6 +78,62 @@ public:
      */
     float getVoltage(const AdcChannel channel);
 
+    /**
+     * Sample a sequence of channels in a single SPI transaction.
+     *
+     * The ADC outputs the result of the previous conversion while the address
+     * of the next channel is being clocked in: channel addresses are thus
+     * pipelined and N channels are sampled with N + 1 words, instead of the
+     * 2N words needed by N calls to getRawValue(). Channels can be listed in
+     * any order and repeated.
+     * In case of hardware failure all the values are set to 0xFFFF.
+     *
+     * @param channels: channels to be sampled, in order.
+     * @param values: buffer for the raw values, in ADC counts.
+     * @param count: number of channels to be sampled, at most MAX_SCAN.
+     * @return true on success, false on failure.
+     */
+    bool scan(const AdcChannel *channels, uint16_t *values, const size_t count);
+
+    /**
+     * Convert a raw value of one of the two ADC channels to voltage.
+     * Returns a signalling NaN if the raw value signals an hardware failure.
+     *
+     * @param channel: channel number.
+     * @param raw: raw value, in ADC counts.
+     * @return channel voltage or signalling NaN on failure.
+     */
+    float toVoltage(const AdcChannel channel, const uint16_t raw) const;
+
+    /**
+     * Convert a fractional raw value of one of the two ADC channels, like the
+     * average of multiple samples, to voltage.
+     *
+     * @param channel: channel number.
+     * @param raw: raw value, in ADC counts.
+     * @return channel voltage.
+     */
+    float toVoltage(const AdcChannel channel, const float raw) const;
+
+    /**
+     * Convert a raw value of one of the two ADC channels to voltage, expressed
+     * with a given numeric type. The conversion itself is done in floating
+     * point: this is the entry point of the fixed point sensor conversion path.
+     * Returns the invalid value of the type if the raw value signals an
+     * hardware failure.
+     *
+     * @param channel: channel number.
+     * @param raw: raw value, in ADC counts.
+     * @return channel voltage or invalid value on failure.
+     */
+    template< typename T >
+    T toVoltage(const AdcChannel channel, const uint16_t raw) const
+    {
+        if(raw == 0xFFFF) return NumericTraits< T >::invalid();
+
+        return T(toVoltage(channel, static_cast< float >(raw)));
+    }
+
     /**
      * Set values for conversion offset and slope of a specific channel.
      *
@@ -77,6 +144,16 @@ public:
     void setConversionParameters(const AdcChannel channel, const float slope,
                                  const float offset);
 
+    /**
+     * Select how data is exchanged with the ADC. In DMA mode the channel
+     * selection and sample words are sent in a single transaction and the
+     * calling thread is put to sleep until the transaction completes, while
+     * polled mode busy-waits on the SPI status register. Default mode is DMA.
+     *
+     * @param mode: new transfer mode.
+     */
+    void setTransferMode(const AdcTransfer mode);
+
     /**
      * Copy constructor, deleted as this class is singleton.
      */
@@ -91,13 +168,15 @@ public:
      * operator== always return true: this class is singleton and is always
      * equal to itself.
      */
-    bool operator==(const ADC122S021& other) const { return true; };
+    bool operator==(const ADC122S021&) const { return true; };
 
     /**
      * operator!= always return false: this class is singleton and is never
      * different from itself.
      */
-    bool operator!=(const ADC122S021& other) const { return false; };
+    bool operator!=(const ADC122S021&) const { return false; };
+
+    static constexpr size_t MAX_SCAN = 16;  ///< Maximum channels in a scan
 
 private:
 
@@ -106,6 +185,43 @@ private:
      */
     ADC122S021();
 
+    /**
+     * Exchange a sequence of 16-bit words with the ADC, busy-waiting on the
+     * SPI status register.
+     *
+     * @param tx: words to be sent.
+     * @param rx: buffer for the received words.
+     * @param count: number of words to be exchanged.
+     * @return true on success, false on timeout.
+     */
+    bool transferPolled(const uint16_t *tx, uint16_t *rx, const uint16_t count);
+
+    /**
+     * Exchange a sequence of 16-bit words with the ADC through DMA, the
+     * calling thread sleeps until the end of the transfer or until the
+     * transfer timeout expires.
+     *
+     * @param tx: words to be sent.
+     * @param rx: buffer for the received words.
+     * @param count: number of words to be exchanged.
+     * @return true on success, false on DMA transfer error or timeout.
+     */
+    bool transferDma(const uint16_t *tx, uint16_t *rx, const uint16_t count);
+
+    /**
+     * Exchange a sequence of 16-bit words with the ADC using the currently
+     * selected transfer mode. Chip select is asserted for the whole transfer.
+     *
+     * @param tx: words to be sent.
+     * @param rx: buffer for the received words.
+     * @param count: number of words to be exchanged.
+     * @return true on success, false on failure.
+     */
+    bool transfer(const uint16_t *tx, uint16_t *rx, const uint16_t count);
+
+    static constexpr long long TIMEOUT = 10;    ///< Transfer timeout, in ticks
+
+    AdcTransfer mode;      ///< Current transfer mode
     float CH_OFFSET[2];    ///< Channels' conversion offset
-    float CH_SLOPE[2];     ///< Channels' conversion slope
+    float CH_GAIN[2];      ///< Channels' conversion gain, inverse of the slope
 };
@@ -0,0 +1,99 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits>
+#include "ADC122S021.h"
+
+/*
+ * Hardware independent part of the ADC122S021 driver: channel sequencing and
+ * conversion of the raw values to voltage. The word exchange with the ADC is
+ * implemented by the target driver and by the host one.
+ */
+
+using namespace std;
+
+ADC122S021& ADC122S021::instance()
+{
+    static ADC122S021 adc;
+    return adc;
+}
+
+uint16_t ADC122S021::getRawValue(const AdcChannel channel)
+{
+    uint16_t value;
+    scan(&channel, &value, 1);
+
+    return value;
+}
+
+float ADC122S021::getVoltage(const AdcChannel channel)
+{
+    return toVoltage(channel, getRawValue(channel));
+}
+
+bool ADC122S021::scan(const AdcChannel *channels, uint16_t *values,
+                      const size_t count)
+{
+    if((count == 0) || (count > MAX_SCAN))
+        return false;
+
+    // Word i selects the channel sampled by word i + 1, the incoming value of
+    // the first word is discarded. The last word repeats the address of the
+    // last channel.
+    uint16_t tx[MAX_SCAN + 1];
+    uint16_t rx[MAX_SCAN + 1];
+
+    for(size_t i = 0; i < count; i++)
+        tx[i] = static_cast< uint16_t >(channels[i]) << 11;
+
+    tx[count] = tx[count - 1];
+
+    bool ok = transfer(tx, rx, count + 1);
+    for(size_t i = 0; i < count; i++)
+        values[i] = ok ? rx[i + 1] : 0xFFFF;
+
+    return ok;
+}
+
+float ADC122S021::toVoltage(const AdcChannel channel, const uint16_t raw) const
+{
+    if(raw == 0xFFFF) return numeric_limits< float >::signaling_NaN();
+
+    return toVoltage(channel, static_cast< float >(raw));
+}
+
+float ADC122S021::toVoltage(const AdcChannel channel, const float raw) const
+{
+    uint16_t ch = static_cast< uint16_t >(channel);
+
+    if(raw < CH_OFFSET[ch]) return 0.0f;
+    return (raw - CH_OFFSET[ch]) * CH_GAIN[ch];
+}
+
+void ADC122S021::setConversionParameters(const AdcChannel channel,
+                                         const float slope, const float offset)
+{
+    uint16_t ch   = static_cast< uint16_t >(channel);
+    CH_GAIN[ch]   = 1.0f / slope;
+    CH_OFFSET[ch] = offset;
+}
+
+void ADC122S021::setTransferMode(const AdcTransfer mode)
+{
+    this->mode = mode;
+}
@@ -19,17 +19,21 @@
 #pragma once
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <limits>
 #include "ADC122S021.h"
+#include "common/FixedPoint.h"
 
 /**
  * Driver for FS1015CL mass flow sensor.
  *
  * @param CH: template parameter specifying the ADC channel to which the
  * sensor's analog output is connected.
+ * @param T: numeric type used for the conversion, either float or a fixed
+ * point type like Fixed< 15 >.
  */
-template < AdcChannel CH >
+template < AdcChannel CH, typename T = float >
 class FS1015CL
 {
 public:
@@ -52,25 +56,35 @@ public:
      *
      * @return flow rate in l/min.
      */
-    float getFlowRate()
+    T getFlowRate()
     {
-        float voltage = adc.getVoltage(CH);
+        return getFlowRate(adc.toVoltage< T >(CH, adc.getRawValue(CH)));
+    }
 
+    /**
+     * Convert a voltage sample of the sensor output to flow rate, in standard
+     * l/min.
+     *
+     * @param voltage: sensor output voltage, NaN in case of ADC failure.
+     * @return flow rate in l/min.
+     */
+    T getFlowRate(const T voltage) const
+    {
         // ADC failure
-        if(voltage == std::numeric_limits< float >::signaling_NaN())
+        if(isValid(voltage) == false)
         {
             return voltage;
         }
 
         // Voltage < 0.45V sensor error
         // Voltage > 4.65V sensor over scale
-        if((voltage < 0.45f) || (voltage > 4.65f))
+        if((voltage < T(0.45f)) || (voltage > T(4.65f)))
         {
-            return std::numeric_limits< float >::signaling_NaN();
+            return NumericTraits< T >::invalid();
         }
 
         // Never return a negative flow rate
-        return std::max(0.0f, (voltage - OFFSET) * SLOPE);
+        return std::max(T(0.0f), (voltage - OFFSET) * SLOPE);
     }
 
     /**
@@ -81,13 +95,13 @@ public:
      */
     void setOutputParameters(const float offset, const float slope)
     {
-        OFFSET = offset;
-        SLOPE  = slope;
+        OFFSET = T(offset);
+        SLOPE  = T(slope);
     }
 
 private:
 
-    float OFFSET;       ///< Output offset at 0 SLPM, in volt
-    float SLOPE;        ///< Output slope in SLPM/volt
+    T OFFSET;           ///< Output offset at 0 SLPM, in volt
+    T SLOPE;            ///< Output slope in SLPM/volt
     ADC122S021& adc;    ///< ADC instance
 };
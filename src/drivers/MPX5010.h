@@ -19,17 +19,21 @@
 #pragma once
 
 #include <cstdint>
+#include <cmath>
 #include <limits>
 #include "hwmapping.h"
 #include "ADC122S021.h"
+#include "common/FixedPoint.h"
 
 /**
  * Driver for MPX5010 differential pressure sensor.
  *
  * @param CH: template parameter specifying the ADC channel to which the
  * sensor's analog output is connected.
+ * @param T: numeric type used for the conversion, either float or a fixed
+ * point type like Fixed< 15 >.
  */
-template < AdcChannel CH >
+template < AdcChannel CH, typename T = float >
 class MPX5010
 {
 public:
@@ -53,12 +57,21 @@ public:
      *
      * @return differential pressure in Pa.
      */
-    float getDiffPressure()
+    T getDiffPressure()
     {
-        float voltage = adc.getVoltage(CH);
+        return getDiffPressure(adc.toVoltage< T >(CH, adc.getRawValue(CH)));
+    }
 
+    /**
+     * Convert a voltage sample of the sensor output to differential pressure.
+     *
+     * @param voltage: sensor output voltage, NaN in case of ADC failure.
+     * @return differential pressure in Pa.
+     */
+    T getDiffPressure(const T voltage) const
+    {
         // ADC failure
-        if(voltage == std::numeric_limits< float >::signaling_NaN())
+        if(isValid(voltage) == false)
         {
             return voltage;
         }
@@ -74,8 +87,8 @@ public:
      */
     void calibrateSupplyVoltage(const float vSupply)
     {
-        OFFSET = 0.04f * vSupply;
-        SLOPE  = 1000.0f / (0.09f * vSupply);
+        OFFSET = T(0.04f * vSupply);
+        SLOPE  = T(1000.0f / (0.09f * vSupply));
     }
 
     /**
@@ -86,13 +99,13 @@ public:
      */
     void setOutputParameters(const float offset, const float slope)
     {
-        OFFSET = offset;
-        SLOPE  = slope;
+        OFFSET = T(offset);
+        SLOPE  = T(slope);
     }
 
 private:
 
-    float OFFSET;       ///< Output offset at 0 Pa, in volt
-    float SLOPE;        ///< Output slope in Pa/volt
+    T OFFSET;           ///< Output offset at 0 Pa, in volt
+    T SLOPE;            ///< Output slope in Pa/volt
     ADC122S021& adc;    ///< ADC instance
 };
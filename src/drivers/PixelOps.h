@@ -0,0 +1,120 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/*
+ * Framebuffer kernels of the display driver, working on 16 bit pixels. They
+ * are kept free of mxgui so that they can be benchmarked on the host.
+ */
+
+/**
+ * Fill a run of contiguous pixels with the same color. Pixels are written two
+ * at a time with word-aligned 32 bit stores.
+ *
+ * @param ptr: first pixel of the run.
+ * @param len: number of pixels.
+ * @param color: fill color.
+ */
+inline void fillPixels(uint16_t *ptr, int len, const uint16_t color)
+{
+    typedef uint32_t __attribute__((may_alias)) Word;
+    if(len <= 0) return;
+
+    // Align to a word boundary
+    if(reinterpret_cast< uintptr_t >(ptr) & 2)
+    {
+        *ptr++ = color;
+        len--;
+    }
+
+    Word  word     = static_cast< Word >(color) | static_cast< Word >(color) << 16;
+    Word *wptr     = reinterpret_cast< Word * >(ptr);
+    int   numWords = len / 2;
+
+    // This loop is worth unrolling
+    for(int i = 0; i < numWords / 4; i++)
+    {
+        *wptr++ = word;
+        *wptr++ = word;
+        *wptr++ = word;
+        *wptr++ = word;
+    }
+
+    for(int i = 0; i < (numWords & 3); i++) *wptr++ = word;
+    if(len & 1) *reinterpret_cast< uint16_t * >(wptr) = color;
+}
+
+/**
+ * Fill a column of pixels with the same color.
+ *
+ * @param ptr: topmost pixel of the column.
+ * @param len: number of pixels.
+ * @param stride: distance between two rows, in pixels.
+ * @param color: fill color.
+ */
+inline void fillColumn(uint16_t *ptr, const int len, const int stride,
+                       const uint16_t color)
+{
+    // Pixels are not contiguous, but this loop is still worth unrolling
+    for(int i = 0; i < len / 4; i++)
+    {
+        ptr[0]          = color;
+        ptr[stride]     = color;
+        ptr[2 * stride] = color;
+        ptr[3 * stride] = color;
+        ptr += 4 * stride;
+    }
+
+    for(int i = 0; i < (len & 3); i++)
+    {
+        *ptr = color;
+        ptr += stride;
+    }
+}
+
+/**
+ * Copy a rectangle of pixels between two buffers, one row at a time. When
+ * both buffers are as wide as the rectangle the copy is done at once.
+ *
+ * @param dst: upper left pixel of the destination.
+ * @param dstStride: distance between two rows of the destination, in pixels.
+ * @param src: upper left pixel of the source.
+ * @param srcStride: distance between two rows of the source, in pixels.
+ * @param width: rectangle width, in pixels.
+ * @param height: rectangle height, in pixels.
+ */
+inline void copyPixels(uint16_t *dst, const int dstStride, const uint16_t *src,
+                       const int srcStride, const int width, const int height)
+{
+    if((width == dstStride) && (width == srcStride))
+    {
+        memcpy(dst, src, width * height * sizeof(uint16_t));
+        return;
+    }
+
+    for(int y = 0; y < height; y++)
+    {
+        memcpy(dst, src, width * sizeof(uint16_t));
+        dst += dstStride;
+        src += srcStride;
+    }
+}
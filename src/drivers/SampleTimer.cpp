@@ -0,0 +1,142 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <miosix.h>
+#include "SampleTimer.h"
+
+using namespace miosix;
+
+static Thread * volatile waiting[SampleTimer::NUM_CHANNELS];  // Waiting threads
+
+/**
+ * \internal
+ * Actual implementation of the TIM5 interrupt handler, wakes up the threads
+ * whose compare channel matched.
+ */
+void __attribute__((used)) sampleTimerIrqImpl()
+{
+    uint32_t flags = TIM5->SR & TIM5->DIER;
+    TIM5->SR = ~flags;
+    TIM5->DIER &= ~flags;
+
+    bool reschedule = false;
+    for(uint8_t i = 0; i < SampleTimer::NUM_CHANNELS; i++)
+    {
+        if(((flags & (TIM_SR_CC1IF << i)) == 0) || (waiting[i] == nullptr))
+            continue;
+
+        waiting[i]->IRQwakeup();
+        if(waiting[i]->IRQgetPriority() >
+           Thread::IRQgetCurrentThread()->IRQgetPriority())
+        {
+            reschedule = true;
+        }
+
+        waiting[i] = nullptr;
+    }
+
+    if(reschedule) Scheduler::IRQfindNextThread();
+}
+
+/**
+ * TIM5 interrupt handler.
+ */
+void __attribute__((naked)) TIM5_IRQHandler()
+{
+    saveContext();
+    asm volatile("bl _Z18sampleTimerIrqImplv");
+    restoreContext();
+}
+
+
+
+SampleTimer& SampleTimer::instance()
+{
+    static SampleTimer timer;
+    return timer;
+}
+
+SampleTimer::SampleTimer()
+{
+    RCC->DCKCFGR |= RCC_DCKCFGR_TIMPRE;    // Clock timer at 180MHz
+    RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+    RCC_SYNC();
+
+    /*
+     * Timer clock = 180MHz, counter clock = 1MHz, free running
+     */
+
+    TIM5->CR1  = 0;
+    TIM5->PSC  = 179;
+    TIM5->ARR  = 0xFFFFFFFF;
+    TIM5->CNT  = 0;
+    TIM5->DIER = 0;
+    TIM5->EGR  = TIM_EGR_UG;       // Update registers
+    TIM5->SR   = 0;
+    TIM5->CR1  = TIM_CR1_CEN;      // Start timer
+
+    NVIC_ClearPendingIRQ(TIM5_IRQn);
+    NVIC_SetPriority(TIM5_IRQn, 5);
+    NVIC_EnableIRQ(TIM5_IRQn);
+}
+
+SampleTimer::~SampleTimer()
+{
+    NVIC_DisableIRQ(TIM5_IRQn);
+    TIM5->CR1 = 0;
+    RCC->APB1ENR &= ~RCC_APB1ENR_TIM5EN;
+}
+
+uint32_t SampleTimer::now() const
+{
+    return TIM5->CNT;
+}
+
+bool SampleTimer::waitUntil(const uint32_t time, const uint8_t channel)
+{
+    if(channel >= NUM_CHANNELS)
+        return false;
+
+    // Compare registers are consecutive
+    volatile uint32_t *ccr = &(TIM5->CCR1) + channel;
+    uint32_t          flag = TIM_SR_CC1IF << channel;
+
+    FastInterruptDisableLock dLock;
+
+    *ccr     = time;
+    TIM5->SR = ~flag;
+
+    // If the counter reaches the compare value after this check, the match
+    // flag is set and the interrupt fires as soon as it is enabled.
+    if(static_cast< int32_t >(time - TIM5->CNT) <= 0)
+        return false;
+
+    waiting[channel] = Thread::IRQgetCurrentThread();
+    TIM5->DIER |= TIM_DIER_CC1IE << channel;
+
+    while(waiting[channel] != nullptr)
+    {
+        Thread::IRQwait();
+        {
+            FastInterruptEnableLock eLock(dLock);
+            Thread::yield();
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,84 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Driver for the hardware timer used to pace the acquisition of the analog
+ * sensors. The timer is TIM5, a free running 32-bit counter incrementing every
+ * microsecond. Each of its four compare channels can be used by a thread to
+ * sleep until a given point in time, with a wakeup latency independent of the
+ * kernel tick.
+ */
+class SampleTimer
+{
+public:
+
+    /**
+     * Singleton instance getter.
+     *
+     * @return reference to the singleton instance of this class.
+     */
+    static SampleTimer& instance();
+
+    /**
+     * Destructor.
+     */
+    ~SampleTimer();
+
+    /**
+     * Get the current value of the timer counter.
+     *
+     * @return current time, in microseconds. The value wraps around every
+     * 2^32 microseconds, time differences have to be computed with unsigned
+     * arithmetic.
+     */
+    uint32_t now() const;
+
+    /**
+     * Put the calling thread to sleep until the timer reaches a given value.
+     * Each compare channel can be used by only one thread at a time.
+     *
+     * @param time: wakeup time, in microseconds.
+     * @param channel: compare channel to be used, from 0 to NUM_CHANNELS - 1.
+     * @return true if the thread has been put to sleep, false if the wakeup
+     * time is already expired.
+     */
+    bool waitUntil(const uint32_t time, const uint8_t channel);
+
+    /**
+     * Copy constructor, deleted as this class is singleton.
+     */
+    SampleTimer(const SampleTimer& other) = delete;
+
+    /**
+     * Assignment operator, deleted as this class is singleton.
+     */
+    SampleTimer& operator=(const SampleTimer& other) = delete;
+
+    static constexpr uint8_t NUM_CHANNELS = 4;  ///< Number of compare channels
+
+private:
+
+    /**
+     * Singleton class, constructor is private.
+     */
+    SampleTimer();
+};
@@ -27,8 +27,11 @@
  ***************************************************************************/
 
 #include "display_stm32.h"
+#include "PixelOps.h"
 #include <miosix.h>
 #include <cstdarg>
+#include <cstdlib>
+#include <new>
 
 using namespace std;
 using namespace miosix;
@@ -40,7 +43,7 @@ typedef Gpio<GPIOF_BASE, 9> sda; //SPI MOSI
 typedef Gpio<GPIOC_BASE, 2> csx; //SPI CS
 typedef Gpio<GPIOD_BASE,13> dcx; //Data/command
 typedef Gpio<GPIOD_BASE,12> rdx; //Used only un parallel mode
-typedef Gpio<GPIOD_BASE,11> te;  //Tearing effect output from display, unused
+typedef Gpio<GPIOD_BASE,11> te;  //Tearing effect output from display
 
 /**
  * Send and receive a byte through SPI5
@@ -80,6 +83,57 @@ static void sendCmd(unsigned char cmd, int len, ...)
     va_end(arg);
 }
 
+static DisplayStm32 *irqDisplay=nullptr; ///< Display served by the irqs
+
+/**
+ * Wake a thread from an interrupt, rescheduling if it has higher priority than
+ * the interrupted one
+ * \param t thread to wake
+ */
+static void IRQwakeThread(Thread *t)
+{
+    t->IRQwakeup();
+    if(t->IRQgetPriority()>Thread::IRQgetCurrentThread()->IRQgetPriority())
+        Scheduler::IRQfindNextThread();
+}
+
+/**
+ * DMA2 stream 4 interrupt handler actual implementation, SPI5 TX
+ */
+void __attribute__((used)) displayDmaIrqImpl()
+{
+    if(irqDisplay) irqDisplay->IRQdmaHandler();
+}
+
+/**
+ * DMA2 stream 4 interrupt handler
+ */
+void __attribute__((naked)) DMA2_Stream4_IRQHandler()
+{
+    saveContext();
+    asm volatile("bl _Z17displayDmaIrqImplv");
+    restoreContext();
+}
+
+/**
+ * EXTI lines 10 to 15 interrupt handler actual implementation, only line 11
+ * is used, connected to the display tearing effect output
+ */
+void __attribute__((used)) displayTeIrqImpl()
+{
+    if(irqDisplay) irqDisplay->IRQteHandler();
+}
+
+/**
+ * EXTI lines 10 to 15 interrupt handler
+ */
+void __attribute__((naked)) EXTI15_10_IRQHandler()
+{
+    saveContext();
+    asm volatile("bl _Z16displayTeIrqImplv");
+    restoreContext();
+}
+
 void mxgui::registerDisplayHook(DisplayManager& dm)
 {
     dm.registerDisplay(&DisplayStm32::instance());
@@ -99,6 +153,7 @@ DisplayStm32& DisplayStm32::instance()
 
 void DisplayStm32::doTurnOn()
 {
+    waitRenderComplete();
     LTDC->GCR |= LTDC_GCR_LTDCEN;
     Thread::sleep(40);
     sendCmd(0x29,0); //LCD_DISPLAY_ON
@@ -106,6 +161,7 @@ void DisplayStm32::doTurnOn()
 
 void DisplayStm32::doTurnOff()
 {
+    waitRenderComplete();
     sendCmd(0x28,0); //LCD_DISPLAY_OFF
     LTDC->GCR &=~ LTDC_GCR_LTDCEN;
 }
@@ -136,6 +192,7 @@ void DisplayStm32::clear(Point p1, Point p2, Color color)
 {
     if(p1.x()<0 || p2.x()<p1.x() || p2.x()>=width
      ||p1.y()<0 || p2.y()<p1.y() || p2.y()>=height) return;
+    markDirty(p1.x(),p1.y(),p2.x(),p2.y());
     if((color & 0xff)==(color>>8))
     {
         //Can use memset
@@ -158,25 +215,15 @@ void DisplayStm32::clear(Point p1, Point p2, Color color)
         if(p1.x()==0 && p2.x()==width-1)
         {
             //Can merge lines
-            Color *ptr=framebuffer1+p1.y()*width;
-            int numPixels=(p2.y()-p1.y()+1)*width;
-            //This loop is worth unrolling
-            for(int i=0;i<numPixels/4;i++)
-            {
-                *ptr++=color;
-                *ptr++=color;
-                *ptr++=color;
-                *ptr++=color;
-            }
-            for(int i=0;i<(numPixels & 3);i++) *ptr++=color;
+            fillPixels(framebuffer1+p1.y()*width,(p2.y()-p1.y()+1)*width,color);
         } else {
             //Can't merge lines
             Color *ptr=framebuffer1+p1.x()+width*p1.y();
             short len=p2.x()-p1.x()+1;
             for(short i=p1.y();i<=p2.y();i++)
             {
-                for(short j=0;j<len;j++) *ptr++=color;
-                ptr+=width-len;
+                fillPixels(ptr,len,color);
+                ptr+=width;
             }
         }
     }
@@ -188,6 +235,7 @@ void DisplayStm32::setPixel(Point p, Color color)
 {
     int offset=p.x()+p.y()*width;
     if(offset<0 || offset>=numPixels) return;
+    markDirty(p.x(),p.y(),p.x(),p.y());
     *(framebuffer1+offset)=color;
 }
 
@@ -199,8 +247,8 @@ void DisplayStm32::line(Point a, Point b, Color color)
         short minx=min(a.x(),b.x());
         short maxx=max(a.x(),b.x());
         if(minx<0 || maxx>=width || a.y()<0 || a.y()>=height) return;
-        Color *ptr=framebuffer1+minx+width*a.y();
-        for(short i=minx;i<=maxx;i++) *ptr++=color;
+        markDirty(minx,a.y(),maxx,a.y());
+        fillPixels(framebuffer1+minx+width*a.y(),maxx-minx+1,color);
         return;
     }
     //Vertical line speed optimization
@@ -209,22 +257,35 @@ void DisplayStm32::line(Point a, Point b, Color color)
         short miny=min(a.y(),b.y());
         short maxy=max(a.y(),b.y());
         if(a.x()<0 || a.x()>=width || miny<0 || maxy>=height) return;
-        Color *ptr=framebuffer1+a.x()+width*miny;
-        for(short i=miny;i<=maxy;i++)
-        {
-            *ptr=color;
-            ptr+=width;
-        }
+        markDirty(a.x(),miny,a.x(),maxy);
+        fillColumn(framebuffer1+a.x()+width*miny,maxy-miny+1,width,color);
         return;
     }
-    //General case
-    Line::draw(*this,a,b,color);
+    //General case, Bresenham's algorithm writing straight into the
+    //framebuffer. The bounding box is marked dirty once, instead of going
+    //through setPixel() which would mark each pixel
+    markDirty(min(a.x(),b.x()),min(a.y(),b.y()),
+              max(a.x(),b.x()),max(a.y(),b.y()));
+    short x=a.x(), y=a.y();
+    const short dx=abs(b.x()-a.x()), sx=a.x()<b.x() ? 1 : -1;
+    const short dy=-abs(b.y()-a.y()), sy=a.y()<b.y() ? 1 : -1;
+    int err=dx+dy;
+    for(;;)
+    {
+        if(x>=0 && x<width && y>=0 && y<height)
+            framebuffer1[x+y*width]=color;
+        if(x==b.x() && y==b.y()) break;
+        int e2=2*err;
+        if(e2>=dy) { err+=dy; x+=sx; }
+        if(e2<=dx) { err+=dx; y+=sy; }
+    }
 }
 
 void DisplayStm32::scanLine(Point p, const Color *colors, unsigned short length)
 {
     if(p.x()<0 || static_cast<int>(p.x())+static_cast<int>(length)>width
         ||p.y()<0 || p.y()>=height) return;
+    markDirty(p.x(),p.y(),p.x()+length-1,p.y());
     Color *ptr=framebuffer1+p.x()+p.y()*width;
     memcpy(ptr,colors,length*bpp);
 }
@@ -237,7 +298,8 @@ Color *DisplayStm32::getScanLineBuffer()
 void DisplayStm32::scanLineBuffer(Point p, unsigned short length)
 {
     int offset=p.x()+p.y()*width;
-    if(offset<0 || offset>=numPixels) return;
+    if(offset<0 || offset+length>numPixels) return;
+    markDirty(p.x(),p.y(),p.x()+length-1,p.y());
     memcpy(framebuffer1+offset,buffer,length*bpp);
 }
 
@@ -248,26 +310,37 @@ void DisplayStm32::drawImage(Point p, const ImageBase& img)
     if(p.x()<0 || p.y()<0 || xEnd<p.x() || yEnd<p.y()
         ||xEnd >= width || yEnd >= height) return;
 
-//    const unsigned short *imgData=img.getData();
-//    if(imgData!=0)
-//    {
-//        //TODO Optimized version for in-memory images
-//    } else
-    img.draw(*this,p);
+    //In-memory images are copied straight into the framebuffer
+    if(img.getData()!=0) blitImage(p,img,p.x(),p.y(),xEnd,yEnd);
+    else img.draw(*this,p);
 }
 
 void DisplayStm32::clippedDrawImage(Point p, Point a, Point b, const ImageBase& img)
 {
-//    if(img.getData()==0)
-//    {
-    img.clippedDraw(*this,p,a,b);
-    // render();
-    return;
-//    } //else optimized version for memory-loaded images
-//        //TODO: optimize
-//    }
+    if(img.getData()==0)
+    {
+        img.clippedDraw(*this,p,a,b);
+        return;
+    }
+
+    //Visible part of the image, clipped to both the rectangle and the screen
+    short x0=max<short>(max(p.x(),a.x()),0);
+    short y0=max<short>(max(p.y(),a.y()),0);
+    short x1=min<short>(min<short>(p.x()+img.getWidth()-1,b.x()),width-1);
+    short y1=min<short>(min<short>(p.y()+img.getHeight()-1,b.y()),height-1);
+    if(x1<x0 || y1<y0) return;
+    blitImage(p,img,x0,y0,x1,y1);
 }
 
+bool DisplayStm32::readPixels(Point a, Point b, Color *pixels) const
+{
+    if(a.x()<0 || b.x()<a.x() || b.x()>=width
+     ||a.y()<0 || b.y()<a.y() || b.y()>=height) return false;
+    short len=b.x()-a.x()+1;
+    copyPixels(pixels,len,framebuffer1+a.x()+a.y()*width,width,len,
+               b.y()-a.y()+1);
+    return true;
+}
 
 void DisplayStm32::drawRectangle(Point a, Point b, Color c)
 {
@@ -291,6 +364,8 @@ DisplayStm32::pixel_iterator DisplayStm32::begin(Point p1, Point p2,
         return this->last;
     }
 
+    markDirty(p1.x(),p1.y(),p2.x(),p2.y());
+
     //Set the last iterator to a suitable one-past-the last value
     if(d==DR) this->last=pixel_iterator(Point(p2.x()+1,p1.y()),p2,d,this);
     else this->last=pixel_iterator(Point(p1.x(),p2.y()+1),p2,d,this);
@@ -298,11 +373,32 @@ DisplayStm32::pixel_iterator DisplayStm32::begin(Point p1, Point p2,
     return pixel_iterator(p1,p2,d,this);
 }
 
-DisplayStm32::~DisplayStm32() {}
+DisplayStm32::~DisplayStm32()
+{
+    waitRenderComplete();
+    if(xferThread)
+    {
+        {
+            FastInterruptDisableLock dLock;
+            quit=true;
+            startXfer=true;
+            xferThread->IRQwakeup();
+        }
+        xferThread->join();
+    }
+    NVIC_DisableIRQ(DMA2_Stream4_IRQn);
+    NVIC_DisableIRQ(EXTI15_10_IRQn);
+    irqDisplay=nullptr;
+}
 
 DisplayStm32::DisplayStm32()
-    : framebuffer1(new Color[width*height]),//reinterpret_cast<unsigned short*>(0xd0600000)),
-      buffer(framebuffer1+numPixels)
+    : framebuffer1(new Color[width*height+width]),//reinterpret_cast<unsigned short*>(0xd0600000)),
+      framebuffer2(nullptr), txBuffer(framebuffer1),
+      buffer(framebuffer1+numPixels), numDirty(0), numPending(0), curRect(0),
+      curRow(0), transferring(false), teSync(false), waiting(nullptr),
+      xferThread(nullptr), irqWaiting(nullptr), startXfer(false),
+      teFlag(false), rectDone(false), rectError(false), quit(false),
+      startCycles(0), lastRenderTime(0), maxRenderTime(0)
 {
     {
         FastInterruptDisableLock dLock;
@@ -323,6 +419,7 @@ DisplayStm32::DisplayStm32()
         csx::mode(Mode::OUTPUT);       csx::high();
         dcx::mode(Mode::OUTPUT);
         rdx::mode(Mode::OUTPUT);       rdx::high(); //Original fw seems to leave it low
+        te::mode(Mode::INPUT);
 
         RCC->APB2ENR |= RCC_APB2ENR_LTDCEN | RCC_APB2ENR_SPI5EN;
         RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
@@ -337,6 +434,18 @@ DisplayStm32::DisplayStm32()
             | SPI_CR1_MSTR; //Master mode
     Thread::sleep(1);
 
+    //DMA2 stream 4 channel 2 is SPI5 TX
+    irqDisplay=this;
+    DMA2_Stream4->CR=0;
+    DMA2_Stream4->PAR=reinterpret_cast<unsigned int>(&SPI5->DR);
+    NVIC_ClearPendingIRQ(DMA2_Stream4_IRQn);
+    NVIC_SetPriority(DMA2_Stream4_IRQn,10);
+    NVIC_EnableIRQ(DMA2_Stream4_IRQn);
+
+    //Cycle counter, used to measure the transfer time
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
     //
     // ILI9341 power up sequence -- begin
     //
@@ -376,33 +485,370 @@ DisplayStm32::DisplayStm32()
     setFont(droid11);
     setTextColor(make_pair(Color(0xffff),Color(0x0000)));
     clear(black);
+
+    //Display commands can't be sent from interrupts, as they busy wait on the
+    //SPI, regions are switched by a thread. If it can't be created present()
+    //does the transfer itself
+    xferThread=Thread::create(transferLauncher,1024,PRIORITY_MAX-1,this,
+                              Thread::JOINABLE);
+}
+
+void DisplayStm32::present()
+{
+    waitRenderComplete();
+    if(numDirty==0) return;
+
+    //Regions drawn from now on are collected for the next transfer
+    memcpy(pending,dirty,numDirty*sizeof(DirtyRect));
+    numPending=numDirty;
+    numDirty=0;
+
+    //With double buffering the frame just drawn becomes the front buffer
+    txBuffer=framebuffer1;
+    if(framebuffer2) swap(framebuffer1,framebuffer2);
+
+    //No transfer in progress, the DMA interrupt cannot fire until the first
+    //block is started
+    transferring=true;
+    startCycles=DWT->CYCCNT;
+    if(xferThread)
+    {
+        {
+            FastInterruptDisableLock dLock;
+            startXfer=true;
+            xferThread->IRQwakeup();
+        }
+        //The transfer thread has higher priority, let it start the transfer
+        Thread::yield();
+    } else transfer();
+
+    //Without a back buffer the caller would draw into the frame being sent,
+    //wait for the transfer to end
+    if(framebuffer2==nullptr)
+    {
+        waitRenderComplete();
+        return;
+    }
+
+    //Bring the new back buffer up to date while the front one is transferred
+    for(int i=0;i<numPending;i++)
+    {
+        const DirtyRect& r=pending[i];
+        short len=r.x1-r.x0+1;
+        if(len==width)
+        {
+            int offset=r.y0*width;
+            memcpy(framebuffer1+offset,framebuffer2+offset,(r.y1-r.y0+1)*width*bpp);
+            continue;
+        }
+        for(int y=r.y0;y<=r.y1;y++)
+        {
+            int offset=r.x0+y*width;
+            memcpy(framebuffer1+offset,framebuffer2+offset,len*bpp);
+        }
+    }
+}
+
+void DisplayStm32::waitRenderComplete()
+{
+    FastInterruptDisableLock dLock;
+    while(transferring)
+    {
+        waiting=Thread::IRQgetCurrentThread();
+        Thread::IRQwait();
+        {
+            FastInterruptEnableLock eLock(dLock);
+            Thread::yield();
+        }
+    }
+}
+
+bool DisplayStm32::enableDoubleBuffering()
+{
+    if(framebuffer2) return true;
+    Color *fb=new (nothrow) Color[numPixels];
+    if(fb==nullptr) return false;
+
+    //The new buffer starts as the front one, with the content on screen
+    waitRenderComplete();
+    memcpy(fb,framebuffer1,numPixels*bpp);
+    framebuffer2=fb;
+    return true;
 }
 
-void DisplayStm32::render()
+void DisplayStm32::setTearingSync(bool enable)
 {
-    sendCmd(0x2b,4,0x00,0x00,0x00,0xef);
-    sendCmd(0x2a,4,0x00,0x00,0x01,0x3f);
-    sendCmd(0x2c,0);
+    waitRenderComplete();
+    if(enable==teSync) return;
 
+    if(enable)
+    {
+        {
+            FastInterruptDisableLock dLock;
+            RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+            RCC_SYNC();
+            //EXTI line 11 on port D, rising edge marks the vertical blanking
+            SYSCFG->EXTICR[2]=(SYSCFG->EXTICR[2] & ~SYSCFG_EXTICR3_EXTI11)
+                             | SYSCFG_EXTICR3_EXTI11_PD;
+            EXTI->IMR &= ~EXTI_IMR_MR11;
+            EXTI->RTSR |= EXTI_RTSR_TR11;
+            EXTI->FTSR &= ~EXTI_FTSR_TR11;
+        }
+        NVIC_ClearPendingIRQ(EXTI15_10_IRQn);
+        NVIC_SetPriority(EXTI15_10_IRQn,10);
+        NVIC_EnableIRQ(EXTI15_10_IRQn);
+        sendCmd(0x35,1,0x00); //LCD_TEARING_ON, V-blanking only
+    } else {
+        sendCmd(0x34,0);      //LCD_TEARING_OFF
+        NVIC_DisableIRQ(EXTI15_10_IRQn);
+        FastInterruptDisableLock dLock;
+        EXTI->IMR &= ~EXTI_IMR_MR11;
+        EXTI->RTSR &= ~EXTI_RTSR_TR11;
+    }
+    teSync=enable;
+}
+
+void DisplayStm32::invalidate()
+{
+    numDirty=0;
+    markDirty(0,0,width-1,height-1);
+}
+
+void DisplayStm32::markDirty(short x0, short y0, short x1, short y1)
+{
+    x0=max<short>(x0,0);
+    y0=max<short>(y0,0);
+    x1=min<short>(x1,width-1);
+    y1=min<short>(y1,height-1);
+    if(x1<x0 || y1<y0) return;
+
+    //Look for the region whose area grows the least when merged with the new
+    //one, nothing to do if the new region is already covered
+    int area=(x1-x0+1)*(y1-y0+1);
+    int best=-1;
+    int bestGrowth=0;
+    for(int i=0;i<numDirty;i++)
+    {
+        const DirtyRect& d=dirty[i];
+        if(x0>=d.x0 && x1<=d.x1 && y0>=d.y0 && y1<=d.y1) return;
+
+        int unionArea=(max(x1,d.x1)-min(x0,d.x0)+1)*(max(y1,d.y1)-min(y0,d.y0)+1);
+        int growth=unionArea-(d.x1-d.x0+1)*(d.y1-d.y0+1);
+        if(best<0 || growth<bestGrowth)
+        {
+            best=i;
+            bestGrowth=growth;
+        }
+    }
+
+    //Merge if the union costs no more pixels than the two separate regions,
+    //or if there is no room left for a new region
+    if(best>=0 && (bestGrowth<=area || numDirty==maxDirty))
+    {
+        DirtyRect& d=dirty[best];
+        d.x0=min(x0,d.x0);
+        d.y0=min(y0,d.y0);
+        d.x1=max(x1,d.x1);
+        d.y1=max(y1,d.y1);
+        return;
+    }
+
+    DirtyRect& d=dirty[numDirty++];
+    d.x0=x0;
+    d.y0=y0;
+    d.x1=x1;
+    d.y1=y1;
+}
+
+void DisplayStm32::blitImage(Point p, const ImageBase& img, short x0,
+                             short y0, short x1, short y1)
+{
+    markDirty(x0,y0,x1,y1);
+
+    //Full width images are copied at once, as they are contiguous in the
+    //framebuffer
+    const short imgWidth=img.getWidth();
+    const Color *src=img.getData()+(x0-p.x())+(y0-p.y())*imgWidth;
+    copyPixels(framebuffer1+x0+y0*width,width,src,imgWidth,x1-x0+1,y1-y0+1);
+}
+
+void DisplayStm32::transferLauncher(void *arg)
+{
+    DisplayStm32 *display=reinterpret_cast<DisplayStm32*>(arg);
+    for(;;)
+    {
+        display->waitIrq(display->startXfer);
+        if(display->quit) return;
+        display->transfer();
+    }
+}
+
+void DisplayStm32::transfer()
+{
+    if(teSync)
+    {
+        //Pending flag is set also while the line is masked, clear stale edges
+        {
+            FastInterruptDisableLock dLock;
+            teFlag=false;
+            EXTI->PR=EXTI_PR_PR11;
+            EXTI->IMR |= EXTI_IMR_MR11;
+        }
+        waitIrq(teFlag);
+    }
+
+    //On transfer errors the remaining regions are skipped
+    bool error=false;
+    for(curRect=0;curRect<numPending && error==false;curRect++)
+    {
+        beginRect();
+        {
+            FastInterruptDisableLock dLock;
+            rectDone=false;
+            IRQstartBlock();
+        }
+        waitIrq(rectDone);
+        error=rectError;
+        endRect();
+    }
+
+    unsigned int time=(DWT->CYCCNT-startCycles)/(SystemCoreClock/1000000);
+    lastRenderTime=time;
+    if(time>maxRenderTime) maxRenderTime=time;
+
+    FastInterruptDisableLock dLock;
+    transferring=false;
+    if(waiting)
+    {
+        waiting->IRQwakeup();
+        waiting=nullptr;
+    }
+}
+
+void DisplayStm32::waitIrq(volatile bool& flag)
+{
+    FastInterruptDisableLock dLock;
+    while(flag==false)
+    {
+        irqWaiting=Thread::IRQgetCurrentThread();
+        Thread::IRQwait();
+        {
+            FastInterruptEnableLock eLock(dLock);
+            Thread::yield();
+        }
+    }
+    flag=false;
+}
+
+void DisplayStm32::beginRect()
+{
+    const DirtyRect& r=pending[curRect];
+    curRow=r.y0;
+
+    //The display is configured with rows and columns exchanged: columns span
+    //the 320 pixel side, pages the 240 pixel side
+    sendCmd(0x2a,4,r.x0>>8,r.x0 & 0xff,r.x1>>8,r.x1 & 0xff); //LCD_COLUMN_ADDR
+    sendCmd(0x2b,4,r.y0>>8,r.y0 & 0xff,r.y1>>8,r.y1 & 0xff); //LCD_PAGE_ADDR
+    sendCmd(0x2c,0);                                         //LCD_GRAM
+
+    //Pixel data is sent as 16 bit words through DMA
     SPI5->CR1 &= ~SPI_CR1_SPE;
     SPI5->CR1 |= SPI_CR1_DFF;
     SPI5->CR1 |= SPI_CR1_SPE;
+    SPI5->CR2 |= SPI_CR2_TXDMAEN;
 
     csx::low();
     dcx::high();
+}
 
-    for(unsigned int i = 0; i < numPixels; i++)
-    {
-        SPI5->DR = framebuffer1[i];
-        while((SPI5->SR & SPI_SR_RXNE)==0) ;
-        (void) SPI5->DR;
-    }
+void DisplayStm32::endRect()
+{
+    //DMA completes when the last word is written to the data register, wait
+    //until it is shifted out
+    while((SPI5->SR & SPI_SR_TXE)==0) ;
+    while(SPI5->SR & SPI_SR_BSY) ;
 
     csx::high();
 
+    //Received data has not been read, clear the overrun condition
+    (void) SPI5->DR;
+    (void) SPI5->SR;
+
+    SPI5->CR2 &= ~SPI_CR2_TXDMAEN;
     SPI5->CR1 &= ~SPI_CR1_SPE;
     SPI5->CR1 &= ~SPI_CR1_DFF;
     SPI5->CR1 |= SPI_CR1_SPE;
 }
 
+void DisplayStm32::IRQstartBlock()
+{
+    //Rows of a region spanning the whole screen width are contiguous in the
+    //framebuffer and can be sent in a single block, as long as the block fits
+    //the 16 bit DMA transfer counter
+    const DirtyRect& r=pending[curRect];
+    short len=r.x1-r.x0+1;
+    short rows=1;
+    if(len==width) rows=min<short>(r.y1-curRow+1,0xffff/width);
+
+    DMA2->HIFCR=DMA_HIFCR_CTCIF4
+               | DMA_HIFCR_CHTIF4
+               | DMA_HIFCR_CTEIF4
+               | DMA_HIFCR_CDMEIF4
+               | DMA_HIFCR_CFEIF4;
+    DMA2_Stream4->M0AR=reinterpret_cast<unsigned int>(txBuffer+r.x0+curRow*width);
+    DMA2_Stream4->NDTR=len*rows;
+    DMA2_Stream4->CR=DMA_SxCR_CHSEL_1  //Channel 2
+                   | DMA_SxCR_PL_0     //Medium priority
+                   | DMA_SxCR_MSIZE_0  //16 bit memory access
+                   | DMA_SxCR_PSIZE_0  //16 bit peripheral access
+                   | DMA_SxCR_MINC     //Increment memory address
+                   | DMA_SxCR_DIR_0    //Memory to peripheral
+                   | DMA_SxCR_TCIE     //Interrupt on completion
+                   | DMA_SxCR_TEIE     //Interrupt on error
+                   | DMA_SxCR_EN;
+    curRow+=rows;
+}
+
+void DisplayStm32::IRQdmaHandler()
+{
+    bool error=DMA2->HISR & DMA_HISR_TEIF4;
+    DMA2->HIFCR=DMA_HIFCR_CTCIF4
+               | DMA_HIFCR_CHTIF4
+               | DMA_HIFCR_CTEIF4
+               | DMA_HIFCR_CDMEIF4
+               | DMA_HIFCR_CFEIF4;
+    DMA2_Stream4->CR=0;
+
+    if(transferring==false) return;
+
+    //Next block of the current region
+    if(error==false && curRow<=pending[curRect].y1)
+    {
+        IRQstartBlock();
+        return;
+    }
+
+    //Region completed, the transfer thread moves to the next one
+    rectError=error;
+    rectDone=true;
+    if(irqWaiting)
+    {
+        IRQwakeThread(irqWaiting);
+        irqWaiting=nullptr;
+    }
+}
+
+void DisplayStm32::IRQteHandler()
+{
+    EXTI->PR=EXTI_PR_PR11;
+    EXTI->IMR &= ~EXTI_IMR_MR11;
+
+    teFlag=true;
+    if(irqWaiting)
+    {
+        IRQwakeThread(irqWaiting);
+        irqWaiting=nullptr;
+    }
+}
+
 Color DisplayStm32::pixel_iterator::dummy;
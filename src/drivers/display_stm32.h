@@ -38,6 +38,7 @@
 #include <mxgui/iterator_direction.h>
 #include <mxgui/misc_inst.h>
 #include <mxgui/line.h>
+#include <miosix.h>
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
@@ -179,6 +180,16 @@ public:
     void clippedDrawImage(mxgui::Point p, mxgui::Point a, mxgui::Point b,
                           const mxgui::ImageBase& img) override;
 
+    /**
+     * Copy a region of the framebuffer, as last drawn, to a buffer
+     * \param a upper left corner of the region
+     * \param b lower right corner of the region
+     * \param pixels buffer where pixels are copied row by row, must have room
+     * for the whole region
+     * \return false if the region is not fully inside the screen
+     */
+    bool readPixels(mxgui::Point a, mxgui::Point b, mxgui::Color *pixels) const;
+
     /**
      * Draw a rectangle (not filled) with the desired color
      * \param a upper left corner of the rectangle
@@ -188,10 +199,71 @@ public:
     void drawRectangle(mxgui::Point a, mxgui::Point b, mxgui::Color c) override;
 
     /**
-     * Render framebuffer on screen, this function has to be called every time
-     * the screen needs to be updated.
+     * Show on screen what has been drawn so far, this function has to be
+     * called every time the screen needs to be updated. Only the regions of
+     * the framebuffer modified since the last call are sent to the display.
+     * The transfer is done through DMA, if a previous transfer is still in
+     * progress this function waits for its completion first.
+     * When double buffering is enabled the frame just drawn becomes the front
+     * buffer and is transferred in the background, while drawing continues on
+     * the back buffer. Otherwise this function returns once the transfer is
+     * completed, as drawing would change the frame being sent.
+     */
+    void present();
+
+    /**
+     * Wait until the framebuffer transfer started by the last call to
+     * present() is completed. Returns immediately if no transfer is in
+     * progress.
+     */
+    void waitRenderComplete();
+
+    /**
+     * \return true if a framebuffer transfer is in progress
      */
-    void render();
+    bool isRendering() const { return transferring; }
+
+    /**
+     * \return the duration of the last framebuffer transfer, in microseconds
+     */
+    unsigned int getRenderTime() const { return lastRenderTime; }
+
+    /**
+     * \return the longest framebuffer transfer so far, in microseconds
+     */
+    unsigned int getMaxRenderTime() const { return maxRenderTime; }
+
+    /**
+     * Mark the whole framebuffer as modified, so that the next present() will
+     * redraw the entire screen.
+     */
+    void invalidate();
+
+    /**
+     * Allocate a second framebuffer and switch to double buffering. Drawing
+     * then never touches the buffer being transferred: the display only shows
+     * complete frames and drawing does not have to wait for the transfer.
+     * \return true on success, false if the second framebuffer could not be
+     * allocated, in which case the display stays single buffered
+     */
+    bool enableDoubleBuffering();
+
+    /**
+     * \return true if double buffering is enabled
+     */
+    bool isDoubleBuffered() const { return framebuffer2!=nullptr; }
+
+    /**
+     * Synchronize the start of the transfers with the tearing effect output
+     * of the display, so that the display controller does not scan a region
+     * while it is being updated. With synchronization enabled, the transfer
+     * thread arms the tearing effect interrupt and starts the transfer at the
+     * beginning of the next vertical blanking period. Regions which take
+     * longer than a refresh period to be transferred may still tear.
+     * Requires the TE line of the display to be connected.
+     * \param enable true to enable synchronization
+     */
+    void setTearingSync(bool enable);
 
     /**
      * Pixel iterator. A pixel iterator is an output iterator that allows to
@@ -337,6 +409,92 @@ private:
      */
     DisplayStm32();
 
+    /**
+     * Rectangular region of the framebuffer, corners included
+     */
+    struct DirtyRect
+    {
+        short x0, y0, x1, y1;
+    };
+
+    /**
+     * Mark a region of the framebuffer as modified. Coordinates are clipped
+     * to the screen size.
+     * \param x0 left column
+     * \param y0 top row
+     * \param x1 right column
+     * \param y1 bottom row
+     */
+    void markDirty(short x0, short y0, short x1, short y1);
+
+    /**
+     * Copy a region of an in-memory image into the framebuffer, one memcpy
+     * per row. The region must be fully inside both the image and the screen.
+     * \param p position of the upper left corner of the image
+     * \param img image, getData() must not return null
+     * \param x0 left column of the region, in screen coordinates
+     * \param y0 top row of the region
+     * \param x1 right column of the region
+     * \param y1 bottom row of the region
+     */
+    void blitImage(mxgui::Point p, const mxgui::ImageBase& img, short x0,
+                   short y0, short x1, short y1);
+
+    /**
+     * Entry point of the transfer thread, runs a transfer each time present()
+     * requests one
+     * \param arg the display
+     */
+    static void transferLauncher(void *arg);
+
+    /**
+     * Transfer the pending regions to the display, waiting for the tearing
+     * effect first if synchronization is enabled. Display commands are sent
+     * from here, in thread context, the interrupts only chain the DMA blocks
+     * of a region.
+     */
+    void transfer();
+
+    /**
+     * Block until an interrupt sets a flag, then clear it
+     * \param flag flag to wait for
+     */
+    void waitIrq(volatile bool& flag);
+
+    /**
+     * Set the display window to the current region to be transferred and
+     * prepare the SPI for pixel data.
+     */
+    void beginRect();
+
+    /**
+     * Wait for the end of the transfer of the current region and restore the
+     * SPI for command transfers.
+     */
+    void endRect();
+
+    /**
+     * Start the DMA transfer of the next block of contiguous pixels of the
+     * current region.
+     * Called by the transfer thread to start a region, or from the DMA
+     * interrupt.
+     */
+    void IRQstartBlock();
+
+    /**
+     * DMA transfer complete interrupt, advances the transfer to the next block
+     * and wakes the transfer thread at the end of the region.
+     */
+    void IRQdmaHandler();
+
+    /**
+     * Tearing effect interrupt, wakes the transfer thread waiting for it.
+     */
+    void IRQteHandler();
+
+    friend void displayDmaIrqImpl();
+    friend void displayTeIrqImpl();
+
     #if defined MXGUI_ORIENTATION_VERTICAL
     static const short int width=240;
     static const short int height=320;
@@ -350,14 +508,33 @@ private:
     #error No orientation defined
     #endif
 
-    /**
-     * Pointer to the memory mapped display.
-     */
-    mxgui::Color * const framebuffer1;
+    mxgui::Color *framebuffer1; ///< Framebuffer being drawn
+    mxgui::Color *framebuffer2; ///< Front buffer, nullptr if single buffered
+    const mxgui::Color *txBuffer; ///< Framebuffer being transferred
     mxgui::Color *buffer; ///< For scanLineBuffer
     pixel_iterator last; ///< Last iterator for end of iteration check
     static const unsigned int bpp=sizeof(mxgui::Color); ///< Bytes per pixel
     static const int numPixels=width*height; ///< Number of pixels of the display
+    static const int maxDirty=16; ///< Maximum number of dirty regions
+    DirtyRect dirty[maxDirty]; ///< Regions modified since last present()
+    int numDirty; ///< Number of dirty regions
+    DirtyRect pending[maxDirty]; ///< Regions being transferred
+    int numPending; ///< Number of regions being transferred
+    int curRect; ///< Region currently being transferred
+    short curRow; ///< Next row of the current region to be transferred
+    volatile bool transferring; ///< A transfer is in progress
+    bool teSync; ///< Transfers start on the tearing effect signal
+    miosix::Thread * volatile waiting; ///< Thread waiting for end of transfer
+    miosix::Thread *xferThread; ///< Thread sending the display commands
+    miosix::Thread * volatile irqWaiting; ///< Thread waiting in waitIrq()
+    volatile bool startXfer; ///< present() requested a transfer
+    volatile bool teFlag; ///< Tearing effect edge received
+    volatile bool rectDone; ///< DMA finished the current region
+    volatile bool rectError; ///< DMA error on the current region
+    volatile bool quit; ///< Transfer thread must terminate
+    unsigned int startCycles; ///< Cycle counter at transfer start
+    volatile unsigned int lastRenderTime; ///< Last transfer time, in us
+    volatile unsigned int maxRenderTime; ///< Longest transfer time, in us
 };
 
 #endif //DISPLAY_STM32_H
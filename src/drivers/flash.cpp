@@ -47,6 +47,16 @@ static inline bool unlock()
 }
 
 
+uintptr_t flash_sectorAddress(const uint8_t secNum)
+{
+    // Sectors 0 to 3 are 16kB, sector 4 is 64kB, the remaining ones are 128kB
+    if(secNum > 11) return 0;
+    if(secNum < 4)  return 0x08000000 + (secNum * 0x4000);
+    if(secNum == 4) return 0x08010000;
+
+    return 0x08020000 + ((secNum - 5) * 0x20000);
+}
+
 bool flash_eraseSector(const uint8_t secNum)
 {
     if(secNum > 11) return false;
@@ -66,7 +76,7 @@ bool flash_eraseSector(const uint8_t secNum)
     return true;
 }
 
-void flash_write(const uint32_t address, const void *data, const size_t len)
+void flash_write(const uintptr_t address, const void *data, const size_t len)
 {
     if(unlock() == false) return;
     if((data == NULL) || (len == 0)) return;
@@ -27,6 +27,15 @@
  * writing.
  */
 
+/**
+ * Get the starting address of one sector of the MCU flash memory.
+ *
+ * @param secNum: sector number.
+ * @return address of the first byte of the sector, 0 if the sector does not
+ * exist.
+ */
+uintptr_t flash_sectorAddress(const uint8_t secNum);
+
 /**
  * Erase one sector of the MCU flash memory.
  *
@@ -42,4 +51,4 @@ bool flash_eraseSector(const uint8_t secNum);
  * @param data: data to be written.
  * @param len: data length.
  */
-void flash_write(const uint32_t address, const void *data, const size_t len);
+void flash_write(const uintptr_t address, const void *data, const size_t len);
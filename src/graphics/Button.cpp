@@ -47,7 +47,7 @@ Button::~Button()
 
 }
 
-void Button::draw(mxgui::DrawingContext& dc)
+void Button::doDraw(mxgui::DrawingContext& dc)
 {
     static const unsigned short tlp[]=
     {
@@ -33,11 +33,12 @@
 #include <image.h>
 #include <point.h>
 #include <level2/input.h>
+#include "Widget.h"
 
 /**
  * Class for a clickable button with label.
  */
-class Button
+class Button : public Widget
 {
 public:
 
@@ -70,7 +71,7 @@ public:
     /**
      * Destructor.
      */
-    ~Button();
+    virtual ~Button();
 
     /**
      * Get the coordinates of the button's upper left corner.
@@ -96,12 +97,14 @@ public:
         {
             down = true;
             if(togglable) clicked = !clicked;
+            setDirty();
             return true;
         }
 
-        if(e.getEvent() == EventType::TouchUp)
+        if((e.getEvent() == EventType::TouchUp) && down)
         {
             down = false;
+            setDirty();
         }
 
         return false;
@@ -115,10 +118,12 @@ public:
         return clicked;
     }
 
+protected:
+
     /**
      * Draw the button
      */
-    void draw(mxgui::DrawingContext& dc);
+    virtual void doDraw(mxgui::DrawingContext& dc) override;
 
 private:
 
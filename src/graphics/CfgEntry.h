@@ -21,52 +21,76 @@
 #include <graphics/graphics.h>
 
 template< class T >
-class CfgEntry
+class CfgEntry : public Widget
 {
 public:
 
     /**
      *
      */
-    CfgEntry(const mxgui::Point startPoint, const std::string& label,
-             T& refValue) : startPoint(startPoint), label(label),
-             value(refValue) { }
+    CfgEntry(const mxgui::Point startPoint, const int width,
+             const std::string& label, T& refValue) : startPoint(startPoint),
+             label(label), value(refValue),
+             button(mxgui::Point(startPoint.x() + width - spacing - btnWidth,
+                                 startPoint.y()),
+                    btnWidth, btnHeight, "Set", mxgui::droid21) { }
 
     /**
      *
      */
-    ~CfgEntry() { }
+    virtual ~CfgEntry() { }
 
    /**
     *
     */
     bool update(mxgui::Event& e, mxgui::DrawingContext& dc)
     {
-        using namespace mxgui;
+        char text[32];
+        toText(text, sizeof(text), value);
+        if(shown != text)
+        {
+            shown = text;
+            setDirty();
+        }
+
+        bool pressed = button.handleTouchEvent(e);
+        draw(dc);
+        button.draw(dc);
+
+        return pressed;
+    }
+
+    /**
+     *
+     */
+    virtual void invalidate() override
+    {
+        Widget::invalidate();
+        button.invalidate();
+    }
 
-        int btnOffset = dc.getWidth()
-                      - spacing
-                      - btnWidth;
+protected:
+
+    /**
+     *
+     */
+    virtual void doDraw(mxgui::DrawingContext& dc) override
+    {
+        using namespace mxgui;
 
         int textOffset = (btnHeight - droid21.getHeight()) / 2;
 
-        mxgui::Point btnPoint(startPoint.x() + btnOffset, startPoint.y());
         mxgui::Point lblPoint(startPoint.x() + spacing,
                               startPoint.y() + textOffset);
         mxgui::Point txtPoint(lblPoint.x() + 6*spacing, lblPoint.y());
+        mxgui::Point txtEnd(button.getUpperLeftCorner().x() - 1,
+                            txtPoint.y() + droid21.getHeight() - 1);
 
-        char text[32];
-        toText(text, sizeof(text), value);
-
+        dc.setFont(droid21);
         dc.setTextColor(black, lightGrey);
         dc.write(lblPoint, label.c_str());
-        dc.write(txtPoint, text);
-
-        Button bt(btnPoint, btnWidth, btnHeight, "Set", droid21);
-        bool pressed = bt.handleTouchEvent(e);
-        bt.draw(dc);
-
-        return pressed;
+        dc.clear(txtPoint, txtEnd, lightGrey);
+        dc.write(txtPoint, shown.c_str());
     }
 
 private:
@@ -84,9 +108,10 @@ private:
     static constexpr int btnHeight = 30;
 
     mxgui::Point      startPoint;
-    mxgui::Point      textPoint;
     const std::string label;
     T&                value;
+    Button            button;
+    std::string       shown;
 };
 
 
@@ -90,7 +90,9 @@ void ConfirmBox::draw(mxgui::DrawingContext& dc, const std::string& line)
         dc.write(Point(x, y), secondLine.c_str());
     }
 
-    // "Yes" and "No" buttons
+    // "Yes" and "No" buttons, drawn over the new background
+    btnYes.invalidate();
+    btnNo.invalidate();
     btnYes.draw(dc);
     btnNo.draw(dc);
 }
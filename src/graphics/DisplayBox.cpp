@@ -30,6 +30,7 @@
 #include "DisplayBox.h"
 
 #include <stdio.h>
+#include <algorithm>
 
 using namespace mxgui;
 
@@ -50,45 +51,69 @@ DisplayBox::DisplayBox(const mxgui::Point a, const mxgui::Point b,
                        const mxgui::Font& font) :
                        a(a), b(b), sideMargin(sideMargin),
                        entryMargin(entryMargin), labels(labels),
+                       redraw(true), cache(cacheSize),
                        bgColor(bgColor), labelColor(labelColor), font(font)
 {
     // Compute vertical spacing and initialise the entry vector
     size_t nElems = labels.size();
     ySpacing = (b.y() - a.y() - nElems * font.getHeight())/(nElems + 1);
     entries.assign(nElems, std::make_pair("", white));
+    changed.assign(nElems, false);
 }
 
 void DisplayBox::setEntryValue(const int entry, const std::string& text,
                                const mxgui::Color color)
 {
     if(static_cast< size_t >(entry) >= entries.size()) return;
+    if((entries[entry].first == text) && (entries[entry].second == color))
+        return;
+
     entries[entry].first  = text;
     entries[entry].second = color;
+    changed[entry]        = true;
+    setDirty();
 }
 
 
-void DisplayBox::draw(mxgui::DrawingContext& dc)
+void DisplayBox::doDraw(mxgui::DrawingContext& dc)
 {
-    // Draw background
-    FilledRectangle rect(a, b, bgColor, bgColor);
-    rect.draw(dc);
-
-    // Draw labels and entries
-    dc.setFont(font);
     int x = a.x() + sideMargin;
     int y = a.y() + ySpacing;
 
-    for(size_t i = 0; i < labels.size(); i++)
+    if(redraw)
     {
-        Point pl(x, y);
+        // Draw background and labels
+        FilledRectangle rect(a, b, bgColor, bgColor);
+        rect.draw(dc);
+
+        dc.setFont(font);
         dc.setTextColor(labelColor, bgColor);
-        dc.write(pl, labels[i].c_str());
+        for(size_t i = 0; i < labels.size(); i++)
+        {
+            Point pl(x, y + i * (font.getHeight() + ySpacing));
+            dc.write(pl, labels[i].c_str());
+        }
+    }
 
-        Point pe(x + entryMargin, y);
-        dc.setTextColor(entries[i].second, bgColor);
-        dc.write(pe, entries[i].first.c_str());
+    // Draw the entries, clearing first the space of the previous text
+    for(size_t i = 0; i < entries.size(); i++)
+    {
+        if(redraw || changed[i])
+        {
+            Point pe(x + entryMargin, y);
+            if(redraw == false)
+            {
+                int xEnd = std::min< int >(b.x(), dc.getWidth() - 1);
+                dc.clear(pe, Point(xEnd, y + font.getHeight() - 1), bgColor);
+            }
+
+            cache.write(dc, pe, entries[i].first, font, entries[i].second,
+                        bgColor);
+            changed[i] = false;
+        }
 
         y += font.getHeight() + ySpacing;
     }
-}
 
+    redraw = false;
+}
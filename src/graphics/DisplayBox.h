@@ -33,6 +33,8 @@
 #include <point.h>
 #include <color.h>
 #include <misc_inst.h>
+#include "TextCache.h"
+#include "Widget.h"
 #include <vector>
 #include <string>
 
@@ -40,7 +42,7 @@
  * Class for drawing a display box containing labels and text fields representing
  * values or parameters.
  */
-class DisplayBox
+class DisplayBox : public Widget
 {
 public:
 
@@ -81,7 +83,7 @@ public:
     /**
      * Destructor.
      */
-    ~DisplayBox() { }
+    virtual ~DisplayBox() { }
 
     /**
      * Get the coordinates of the display box's upper left corner.
@@ -96,7 +98,8 @@ public:
     mxgui::Point getLowerRightCorner() { return b; }
 
     /**
-     * Set the text of a given entry.
+     * Set the text of a given entry. Setting the same text and color the entry
+     * already has does not cause it to be redrawn.
      * \param entry: number of the entry to be updated, starting from zero.
      * \param text: text to be displayed.
      * \param color: text color.
@@ -105,12 +108,26 @@ public:
                        const mxgui::Color color = mxgui::white);
 
     /**
-     * Draw the text box.
+     * Force the whole box to be redrawn at next draw(), otherwise only the
+     * entries changed since the last draw are redrawn.
      */
-    void draw(mxgui::DrawingContext& dc);
+    virtual void invalidate() override
+    {
+        Widget::invalidate();
+        redraw = true;
+    }
+
+protected:
+
+    /**
+     * Draw the display box.
+     */
+    virtual void doDraw(mxgui::DrawingContext& dc) override;
 
 private:
 
+    static constexpr size_t cacheSize = 24;             // Glyphs kept in the text cache.
+
     mxgui::Point a;                                     // Uppper left corner.
     mxgui::Point b;                                     // Lower right corner.
     int sideMargin;                                     // Side margin.
@@ -119,6 +136,9 @@ private:
     const std::vector< std::string >& labels;           // Entry labels.
     std::vector< std::pair< std::string,
                             mxgui::Color > > entries;   // Entries.
+    std::vector< bool > changed;                        // Entries to be redrawn.
+    bool redraw;                                        // Whole box to be redrawn.
+    TextCache cache;                                    // Entry text cache.
     mxgui::Color bgColor;                               // Background color.
     const mxgui::Color labelColor;                      // Label text color.
     const mxgui::Font& font;                            // Text font.
@@ -70,7 +70,14 @@ Keypad::Keypad (const mxgui::Point p) :
     memset(input, 0x00, sizeof(input));
 }
 
-void Keypad::draw(mxgui::DrawingContext& dc)
+void Keypad::invalidate()
+{
+    Widget::invalidate();
+    textBox.invalidate();
+    for(uint8_t i = 0; i < 12; i++) keyboard[i]->invalidate();
+}
+
+void Keypad::doDraw(mxgui::DrawingContext& dc)
 {
 
     ShadowRectangle borders(startPoint, totalWidth, totalHeigth,
@@ -81,8 +88,15 @@ void Keypad::draw(mxgui::DrawingContext& dc)
                     fillStart.y() + totalHeigth - 1);
     dc.clear(fillStart, fillStop, grey);
     borders.draw(dc);
+
+    // Background has been overwritten, all the elements have to be redrawn
+    textBox.invalidate();
     textBox.draw(dc);
-    for(uint8_t i = 0; i < 12; i++) keyboard[i]->draw(dc);
+    for(uint8_t i = 0; i < 12; i++)
+    {
+        keyboard[i]->invalidate();
+        keyboard[i]->draw(dc);
+    }
 }
 
 bool Keypad::handleEvent(mxgui::Event& e, mxgui::DrawingContext& dc)
@@ -92,7 +106,7 @@ bool Keypad::handleEvent(mxgui::Event& e, mxgui::DrawingContext& dc)
      * - when "OK" button is pressed, input text is disabled.
      * - once the dot button has been pressed, avoids adding two dots in the
      *   input string.
-     * - text box is updated only when a button is pressed, to avoid flickering
+     * - buttons and text box are redrawn only when their state changes
      */
     for(int i = 0; i < 12; i++)
     {
@@ -107,15 +121,12 @@ bool Keypad::handleEvent(mxgui::Event& e, mxgui::DrawingContext& dc)
             if(i == 9) dotPressed = true;
         }
 
+        if(pressed) textBox.write(input);
         keyboard[i]->draw(dc);
-
-        if(pressed)
-        {
-            textBox.write(input);
-            textBox.draw(dc);
-        }
     }
 
+    textBox.draw(dc);
+
     return okPressed;
 }
 
@@ -35,11 +35,12 @@
 #include <cstdint>
 #include "Button.h"
 #include "TextBox.h"
+#include "Widget.h"
 
 /**
  * Class for drawing and managing an input keypad.
  */
-class Keypad
+class Keypad : public Widget
 {
 public:
 
@@ -59,7 +60,7 @@ public:
     /**
      * Destructor.
      */
-    ~Keypad() { }
+    virtual ~Keypad() { }
 
     /**
      * Get the coordinates of the keypad's upper left corner.
@@ -90,9 +91,10 @@ public:
     static int getHeight() { return totalHeigth; }
 
     /**
-     * Draw the keypad.
+     * Force the whole keypad, buttons and text box included, to be redrawn at
+     * next draw().
      */
-    void draw(mxgui::DrawingContext& dc);
+    virtual void invalidate() override;
 
     /**
      * Handle a keyboard event, updating the inserted number and redrawing the
@@ -116,6 +118,13 @@ public:
      */
     float getNumber();
 
+protected:
+
+    /**
+     * Draw the keypad.
+     */
+    virtual void doDraw(mxgui::DrawingContext& dc) override;
+
 private:
 
     mxgui::Point startPoint;    // Keypad starting point, its upper left corner.
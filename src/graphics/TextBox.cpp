@@ -44,7 +44,7 @@ TextBox::TextBox(const mxgui::Point a, const int width, const int height,
                  TextBox(a, Point(a.x() + width, a.y() + height),
                             bgColor, textColor, font) { }
 
-void TextBox::draw(mxgui::DrawingContext& dc)
+void TextBox::doDraw(mxgui::DrawingContext& dc)
 {
     // Draw borders
     ShadowRectangle rect(a, b, make_pair(darkGrey, lightGrey));
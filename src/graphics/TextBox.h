@@ -32,11 +32,12 @@
 #include <display.h>
 #include <point.h>
 #include <color.h>
+#include "Widget.h"
 
 /**
  * Simple class for drawing text boxes.
  */
-class TextBox
+class TextBox : public Widget
 {
 public:
 
@@ -66,7 +67,7 @@ public:
     /**
      * Destructor.
      */
-    ~TextBox() { }
+    virtual ~TextBox() { }
 
     /**
      * Get the coordinates of the rectangle's upper left corner.
@@ -84,12 +85,20 @@ public:
      * Set the text box content.
      * \param text: text to be display.
      */
-    void write(const std::string& text) { this->text = text; }
+    void write(const std::string& text)
+    {
+        if(text == this->text) return;
+
+        this->text = text;
+        setDirty();
+    }
+
+protected:
 
     /**
      * Draw the text box.
      */
-    void draw(mxgui::DrawingContext& dc);
+    virtual void doDraw(mxgui::DrawingContext& dc) override;
 
 private:
 
@@ -0,0 +1,124 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/display_stm32.h>
+#include <algorithm>
+#include <image.h>
+#include "TextCache.h"
+
+using namespace std;
+using namespace mxgui;
+
+TextCache::TextCache(const size_t capacity) : capacity(capacity), useCount(0)
+{
+    glyphs.reserve(capacity);
+}
+
+void TextCache::write(mxgui::DrawingContext& dc, const mxgui::Point p,
+                      const std::string& text, const mxgui::Font& font,
+                      const mxgui::Color fgColor, const mxgui::Color bgColor)
+{
+    // Text cut at the bottom border goes through the font engine
+    if(p.y() + font.getHeight() > dc.getHeight())
+    {
+        dc.setFont(font);
+        dc.setTextColor(fgColor, bgColor);
+        dc.write(p, text.c_str());
+        return;
+    }
+
+    short x = p.x();
+
+    for(size_t i = 0; i < text.size(); i++)
+    {
+        char  str[2] = { text[i], '\0' };
+        short width  = font.calculateLength(str);
+
+        // Characters not in the font take no space
+        if(width <= 0) continue;
+
+        // The rest of the text is truncated at the right border by the font
+        // engine
+        if(x + width > dc.getWidth())
+        {
+            dc.setFont(font);
+            dc.setTextColor(fgColor, bgColor);
+            dc.write(Point(x, p.y()), text.c_str() + i);
+            return;
+        }
+
+        writeGlyph(dc, Point(x, p.y()), text[i], width, font, fgColor,
+                   bgColor);
+        x += width;
+    }
+}
+
+void TextCache::writeGlyph(mxgui::DrawingContext& dc, const mxgui::Point p,
+                           const char c, const short width,
+                           const mxgui::Font& font, const mxgui::Color fgColor,
+                           const mxgui::Color bgColor)
+{
+    useCount += 1;
+
+    for(auto& glyph : glyphs)
+    {
+        if((glyph.c != c) || (glyph.font != &font) ||
+           (glyph.fgColor != fgColor) || (glyph.bgColor != bgColor)) continue;
+
+        glyph.lastUse = useCount;
+        Image img(glyph.height, glyph.width, glyph.pixels.data());
+        dc.drawImage(p, img);
+        return;
+    }
+
+    // Miss, render the character through the font engine
+    char str[2] = { c, '\0' };
+    dc.setFont(font);
+    dc.setTextColor(fgColor, bgColor);
+    dc.write(p, str);
+
+    if(capacity == 0) return;
+
+    // Capture the rendered pixels, replacing the least recently used glyph
+    Glyph glyph;
+    glyph.c       = c;
+    glyph.font    = &font;
+    glyph.fgColor = fgColor;
+    glyph.bgColor = bgColor;
+    glyph.width   = width;
+    glyph.height  = font.getHeight();
+    glyph.lastUse = useCount;
+    glyph.pixels.resize(glyph.width * glyph.height);
+
+    Point b(p.x() + glyph.width - 1, p.y() + glyph.height - 1);
+    if(DisplayStm32::instance().readPixels(p, b, glyph.pixels.data()) == false)
+        return;
+
+    if(glyphs.size() < capacity)
+    {
+        glyphs.push_back(std::move(glyph));
+        return;
+    }
+
+    auto lru = min_element(glyphs.begin(), glyphs.end(),
+                           [](const Glyph& lhs, const Glyph& rhs)
+                           {
+                               return lhs.lastUse < rhs.lastUse;
+                           });
+    *lru = std::move(glyph);
+}
@@ -0,0 +1,107 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <display.h>
+#include <point.h>
+#include <color.h>
+#include <vector>
+#include <string>
+
+/**
+ * Cache of pre-rendered glyphs. The first time a character is written with a
+ * given font and colors, it is rendered through the font engine and the
+ * resulting pixels are captured from the framebuffer; text is then composed
+ * by blitting the cached glyphs side by side, so that strings sharing their
+ * characters, as changing numbers do, hit the cache. When the cache is full,
+ * the least recently used glyph is discarded.
+ */
+class TextCache
+{
+public:
+
+    /**
+     * Constructor.
+     * \param capacity: maximum number of glyphs kept in the cache.
+     */
+    TextCache(const size_t capacity);
+
+    /**
+     * Destructor.
+     */
+    ~TextCache() { }
+
+    /**
+     * Write a text, the text is truncated at the right border of the screen.
+     * \param dc: drawing context.
+     * \param p: upper left corner of the text.
+     * \param text: text to be written.
+     * \param font: text font.
+     * \param fgColor: text color.
+     * \param bgColor: background color.
+     */
+    void write(mxgui::DrawingContext& dc, const mxgui::Point p,
+               const std::string& text, const mxgui::Font& font,
+               const mxgui::Color fgColor, const mxgui::Color bgColor);
+
+    /**
+     * Discard all the cached glyphs.
+     */
+    void clear() { glyphs.clear(); }
+
+private:
+
+    /**
+     * Pre-rendered glyph.
+     */
+    struct Glyph
+    {
+        char                       c;           // Character.
+        const mxgui::Font          *font;       // Text font.
+        mxgui::Color               fgColor;     // Text color.
+        mxgui::Color               bgColor;     // Background color.
+        short                      width;       // Width, in pixels.
+        short                      height;      // Height, in pixels.
+        std::vector< mxgui::Color > pixels;     // Rendered pixels.
+        unsigned int               lastUse;     // Time of last use.
+    };
+
+    /**
+     * Draw a single character, from the cache if present, otherwise through
+     * the font engine, capturing the result in the cache. The character must
+     * lie fully inside the screen.
+     * \param dc: drawing context.
+     * \param p: upper left corner of the character.
+     * \param c: character to be written.
+     * \param width: character width, in pixels.
+     * \param font: text font.
+     * \param fgColor: text color.
+     * \param bgColor: background color.
+     */
+    void writeGlyph(mxgui::DrawingContext& dc, const mxgui::Point p,
+                    const char c, const short width, const mxgui::Font& font,
+                    const mxgui::Color fgColor, const mxgui::Color bgColor);
+
+    size_t                  capacity;   // Maximum number of glyphs.
+    std::vector< Glyph >    glyphs;     // Cached glyphs.
+    unsigned int            useCount;   // Counter for least recently used.
+};
+
+#endif // TEXTCACHE_H
@@ -0,0 +1,87 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WIDGET_H
+#define WIDGET_H
+
+#include <display.h>
+
+/**
+ * Base class for retained mode widgets. A widget keeps track of whether its
+ * content on screen is up to date: draw() does nothing unless the state of
+ * the widget changed since the last time it was drawn, or the widget has been
+ * invalidated because the screen area under it has been overwritten.
+ * Widgets containing other widgets draw them as part of their own drawing and
+ * propagate the invalidation to them.
+ */
+class Widget
+{
+public:
+
+    /**
+     * Constructor, a new widget needs to be drawn.
+     */
+    Widget() : dirty(true) { }
+
+    /**
+     * Destructor.
+     */
+    virtual ~Widget() { }
+
+    /**
+     * Draw the widget, if needed.
+     * \param dc: drawing context.
+     */
+    void draw(mxgui::DrawingContext& dc)
+    {
+        if(dirty == false) return;
+
+        dirty = false;
+        doDraw(dc);
+    }
+
+    /**
+     * Force the widget to be completely redrawn at next draw().
+     */
+    virtual void invalidate() { dirty = true; }
+
+    /**
+     * \return true if the widget has to be redrawn.
+     */
+    bool isDirty() const { return dirty; }
+
+protected:
+
+    /**
+     * Actual drawing function, implemented by each widget.
+     * \param dc: drawing context.
+     */
+    virtual void doDraw(mxgui::DrawingContext& dc) = 0;
+
+    /**
+     * Mark the widget as changed, to be called when its state changes in a
+     * way affecting its look.
+     */
+    void setDirty() { dirty = true; }
+
+private:
+
+    bool dirty;     // Widget needs to be redrawn.
+};
+
+#endif // WIDGET_H
@@ -24,6 +24,8 @@
 #include "Rectangle.h"
 #include "CfgEntry.h"
 #include "TextBox.h"
+#include "TextCache.h"
+#include "Widget.h"
 #include "Button.h"
 #include "Keypad.h"
 
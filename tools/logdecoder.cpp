@@ -0,0 +1,154 @@
+/*
+ * MEV board firmware
+ * Copyright (C) 2021 - 2024  Silvano Seva silvano.seva@polimi.it
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host-side decoder for the log of the bed controller.
+ *
+ * By default the input is the framed binary stream produced by the 'd' console
+ * command, see Bed/LogStream.h. With the -r option the input is instead a
+ * sequence of raw logRecord_t records, as stored in the on-device log buffer.
+ * The decoded samples are printed in the same CSV format used by the 'c'
+ * console command.
+ *
+ * Usage: logdecoder [-r] [file], input is read from stdin if no file is given.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "Bed/LogFormat.h"
+#include "Bed/LogStream.h"
+
+using namespace std;
+
+typedef vector< logRecord_t > segment_t;
+
+/**
+ * Read raw records, they all belong to the same segment.
+ */
+static void readRaw(FILE *in, vector< segment_t >& segments)
+{
+    segments.emplace_back();
+
+    logRecord_t rec;
+    while(fread(&rec, sizeof(logRecord_t), 1, in) == 1)
+        segments.back().push_back(rec);
+}
+
+/**
+ * Read a framed stream, starting a new segment each time a frame is lost or
+ * the device reports that some records have been dropped.
+ */
+static void readFramed(FILE *in, vector< segment_t >& segments)
+{
+    LogFrameParser parser;
+    uint16_t expected = 0;
+    size_t   lost     = 0;
+    size_t   gaps     = 0;
+    bool     last     = false;
+    int      c;
+
+    segments.emplace_back();
+
+    while((last == false) && ((c = fgetc(in)) != EOF))
+    {
+        if(parser.push(static_cast< uint8_t >(c)) == false)
+            continue;
+
+        if(parser.sequence() != expected)
+        {
+            lost += static_cast< uint16_t >(parser.sequence() - expected);
+            segments.emplace_back();
+        }
+        else if(parser.isAfterGap())
+        {
+            gaps += 1;
+            segments.emplace_back();
+        }
+
+        segment_t& seg = segments.back();
+        seg.insert(seg.end(), parser.records(),
+                   parser.records() + parser.count());
+
+        expected = parser.sequence() + 1;
+        last     = parser.isLast();
+    }
+
+    if(lost > 0)
+        fprintf(stderr, "%zu frames lost\n", lost);
+
+    if(gaps > 0)
+        fprintf(stderr, "%zu gaps in the device log\n", gaps);
+
+    if(parser.crcErrors() > 0)
+        fprintf(stderr, "%u frames with bad CRC\n", parser.crcErrors());
+
+    if(last == false)
+        fprintf(stderr, "end of dump not received\n");
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *in  = stdin;
+    bool  raw = false;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-r") == 0)
+        {
+            raw = true;
+            continue;
+        }
+
+        in = fopen(argv[i], "rb");
+        if(in == nullptr)
+        {
+            perror(argv[i]);
+            return 1;
+        }
+    }
+
+    // Read all the records at once: the decoder needs the first sync record
+    // to recover the timestamps of the samples preceding it. Records are split
+    // in segments at each discontinuity, the time base is recovered again at
+    // the beginning of each segment.
+    vector< segment_t > segments;
+    if(raw)
+        readRaw(in, segments);
+    else
+        readFramed(in, segments);
+
+    if(in != stdin) fclose(in);
+
+    for(const segment_t& seg : segments)
+    {
+        vector< loggerSample_t > samples(seg.size());
+        LogDecoder decoder;
+        size_t count = decoder.decode(seg.data(), seg.size(), samples.data());
+
+        for(size_t i = 0; i < count; i++)
+        {
+            const loggerSample_t& s = samples[i];
+            printf("%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d\n",
+                   s.timestamp, s.pressure, s.flow1, s.flow2, s.volume1,
+                   s.volume2, (s.valves & 0x01), (s.valves >> 1));
+        }
+    }
+
+    return 0;
+}